@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include <sys/stat.h>
+
+#include "flatast.h"
+#include "parser.h"
+
+// Round trip through the binary tree file: parse, save, map the file back
+// and compare its JSON with the JSON of the parsed tree. Also times the
+// load against parsing the source again. Exits with 1 if they differ.
+
+static std::string makeSource(int functions) {
+    std::string source;
+    for (int i = 0; i < functions; i++) {
+        const std::string n = std::to_string(i);
+        source += "class Shape_" + n + " : Base {\n";
+        source += "    public static var count: i32[] = [1, 2, 3];\n";
+        source += "}\n";
+        source += "func area_" + n + "(width: f64, height: const f64) f64 {\n";
+        source += "    for (var i = 0; i < width; i += 1) {\n";
+        source += "        height = height * 2 - i % 3;\n";
+        source += "    }\n";
+        source += "    print(\"area of\\t\" + \"" + n + "\", width <=> Shape);\n";
+        source += "    return width * height;\n";
+        source += "}\n";
+    }
+    return source;
+}
+
+static long countFlat(const FlatView& tree, NodeId id) {
+    long nodes = 1;
+    forEachChild(tree, id,
+                 [&](NodeId child) { nodes += countFlat(tree, child); });
+    return nodes;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+int main(int argc, char** argv) {
+    const int functions = argc > 1 ? atoi(argv[1]) : 20000;
+    const std::string source = makeSource(functions);
+
+    auto start = std::chrono::steady_clock::now();
+    Lexer lexer(source);
+    ParseContext context;
+    Parser parser(&lexer, &context);
+    Node* root = parser.parse();
+    const double parseTime = since(start);
+    const std::string expected = root->toJSON();
+
+    char path[] = "/tmp/capstone_astfile_bench_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    close(fd);
+
+    start = std::chrono::steady_clock::now();
+    FlatTree(root).save(path);
+    const double saveTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    FlatFile* file = FlatFile::load(path);
+    const double loadTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    const long nodes = countFlat(file->view(), file->view().root);
+    const double walkTime = since(start);
+
+    const std::string loaded = file->view().toJSON();
+    delete file;
+
+    struct stat st;
+    stat(path, &st);
+    unlink(path);
+    std::printf("astfile: %zu bytes of source, %zu bytes of JSON, "
+                "%lld bytes of tree file, %ld nodes\n",
+                source.size(), expected.size(), (long long)st.st_size, nodes);
+    std::printf("astfile: parse %.3fs, save %.3fs, load %.6fs, "
+                "walk loaded %.3fs\n",
+                parseTime, saveTime, loadTime, walkTime);
+
+    if (loaded != expected) {
+        std::printf("astfile: MISMATCH\n");
+        return 1;
+    }
+    return 0;
+}
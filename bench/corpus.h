@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_BENCH_CORPUS
+#define CAPSTONE_BENCH_CORPUS
+
+#include "common.h"
+
+// Random Capstone programs that the parser accepts, built from a small
+// grammar: imports, classes with fields and methods, generic types and
+// calls, nested control flow, deep operator chains, string tables and
+// comments. The same options and seed always give the same program.
+class CorpusGenerator {
+  public:
+    struct Options {
+        size_t bytes = 8 << 20;
+        uint64_t seed = 1;
+        // operators in the longest expressions
+        int expressionDepth = 24;
+        // statements in a block, and how deep blocks nest
+        int blockSize = 8;
+        int blockDepth = 3;
+        // strings in a string table declaration
+        int tableSize = 64;
+        // chance in percent of a comment before a statement
+        int commentPercent = 20;
+    };
+
+    CorpusGenerator(const Options& options)
+        : options(options), state(options.seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    std::string generate(void) {
+        out.clear();
+        out.reserve(options.bytes + 4096);
+        for (int i = 0; i < 8; i++)
+            out += "import lib.module_" + std::to_string(i) + ";\n";
+        while (out.size() < options.bytes) {
+            const int pick = roll(100);
+            if (pick < 20)
+                classDecl();
+            else if (pick < 30)
+                stringTable();
+            else
+                funcDecl(false);
+            out += '\n';
+        }
+        return std::move(out);
+    }
+
+  private:
+    Options options;
+    uint64_t state;
+    std::string out;
+    int indent = 0;
+    int counter = 0;
+
+    uint64_t next(void) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    int roll(int n) {
+        return next() % n;
+    }
+    std::string fresh(const char* stem) {
+        return stem + std::to_string(counter++);
+    }
+
+    void line(const std::string& text) {
+        out.append(indent * 4, ' ');
+        out += text;
+        out += '\n';
+    }
+
+    void comment(void) {
+        if (roll(100) >= options.commentPercent) return;
+        if (roll(2))
+            line("// " + words(4 + roll(12)));
+        else
+            line("/* " + words(8 + roll(24)) + "\n" +
+                 std::string(indent * 4, ' ') + " * " + words(8) + " */");
+    }
+
+    std::string words(int count) {
+        static const char* vocabulary[] = {
+                "the",   "value", "is",    "computed", "once", "per",
+                "frame", "and",   "cached", "until",   "the",  "input",
+                "keys",  "change", "see",   "notes",   "TODO", "fix"};
+        std::string text;
+        for (int i = 0; i < count; i++) {
+            if (i) text += ' ';
+            text += vocabulary[roll(sizeof(vocabulary) / sizeof(*vocabulary))];
+        }
+        return text;
+    }
+
+    // Generics are never nested, and a generic call never names a generic
+    // type: the parser cannot yet end either on a `>>`.
+    std::string type(bool generic = true) {
+        static const char* primitives[] = {"i32", "i64", "u8", "f64", "bool",
+                                           "String"};
+        std::string text =
+                primitives[roll(sizeof(primitives) / sizeof(*primitives))];
+        if (generic && roll(4) == 0)
+            text = std::string(roll(2) ? "List<" : "Map<") + text + ">";
+        if (roll(5) == 0) text += "[]";
+        return text;
+    }
+
+    std::string literal(void) {
+        switch (roll(6)) {
+        case 0: return std::to_string(roll(100000));
+        case 1: return "0x" + std::to_string(roll(9000) + 1000);
+        case 2: return std::to_string(roll(1000)) + ".5e-3";
+        case 3: return "\"" + words(1 + roll(4)) + "\\n\"";
+        case 4: return roll(2) ? "true" : "false";
+        default: return "null";
+        }
+    }
+
+    std::string operand(void) {
+        switch (roll(8)) {
+        case 0:
+        case 1: return literal();
+        case 2: return "self.state.count";
+        case 3: return "$values";
+        case 4: return "!ready";
+        case 5: return "call_" + std::to_string(roll(50)) + "(a, b, 1)";
+        case 6: return "<" + type(false) + "> make(a)";
+        default: return std::string(1, "abcxyz"[roll(6)]);
+        }
+    }
+
+    std::string expression(int operators) {
+        static const char* ops[] = {"+",  "-",  "*",  "/",  "%",  "<<",
+                                    ">>", "<",  ">",  "<=", ">=", "==",
+                                    "!=", "&",  "^",  "|",  "&&", "||"};
+        std::string text = operand();
+        for (int i = 0; i < operators; i++) {
+            text += ' ';
+            text += ops[roll(sizeof(ops) / sizeof(*ops))];
+            text += ' ';
+            text += operand();
+        }
+        if (roll(8) == 0) text += " ? " + operand() + " : " + operand();
+        return text;
+    }
+
+    // mostly short expressions with the occasional very long one
+    std::string someExpression(void) {
+        return expression(roll(10) == 0 ? options.expressionDepth
+                                        : roll(4));
+    }
+
+    void block(int depth) {
+        indent++;
+        const int count = 1 + roll(options.blockSize);
+        for (int i = 0; i < count; i++) statement(depth);
+        indent--;
+    }
+
+    void statement(int depth) {
+        comment();
+        const int pick = depth < options.blockDepth ? roll(10) : roll(5);
+        switch (pick) {
+        case 0:
+            line("var " + fresh("v") + ": " + type() + " = " +
+                 someExpression() + ";");
+            break;
+        case 1: line(std::string(1, "abxy"[roll(4)]) + " += " + someExpression() + ";"); break;
+        case 2: line("print(\"" + words(3) + "\", " + someExpression() + ");"); break;
+        case 3: line("return " + someExpression() + ";"); break;
+        case 4: line("let " + fresh("k") + " = [" + literal() + ", " + literal() + "];"); break;
+        case 5:
+        case 6:
+            line("if (" + someExpression() + ") {");
+            block(depth + 1);
+            line("} else {");
+            block(depth + 1);
+            line("}");
+            break;
+        case 7:
+            line("while (" + someExpression() + ") {");
+            block(depth + 1);
+            line("}");
+            break;
+        default:
+            line("for (var i = 0; i < " + someExpression() + "; i += 1) {");
+            block(depth + 1);
+            line("}");
+        }
+    }
+
+    void funcDecl(bool method) {
+        comment();
+        std::string head = "func " + fresh(method ? "method_" : "func_");
+        head += "(a: " + type() + ", b: const " + type() + ") " + type() + " {";
+        line(head);
+        block(0);
+        line("}");
+    }
+
+    void classDecl(void) {
+        comment();
+        line("class " + fresh("Class") + (roll(2) ? " : Base {" : " {"));
+        indent++;
+        static const char* visibility[] = {"public ", "private ",
+                                           "protected ", ""};
+        const int fields = 1 + roll(6);
+        for (int i = 0; i < fields; i++)
+            line(std::string(visibility[roll(4)]) + (roll(3) ? "" : "static ") +
+                 "var " + fresh("field") + ": " + type() + " = " + literal() +
+                 ";");
+        const int methods = 1 + roll(4);
+        for (int i = 0; i < methods; i++) funcDecl(true);
+        indent--;
+        line("}");
+    }
+
+    void stringTable(void) {
+        comment();
+        line("const " + fresh("table") + ": String[] = [");
+        indent++;
+        for (int i = 0; i < options.tableSize; i++)
+            line("\"" + words(2 + roll(6)) + " \\t\\\"" + std::to_string(i) +
+                 "\\\"\",");
+        line("\"end\"");
+        indent--;
+        line("];");
+    }
+};
+
+#endif
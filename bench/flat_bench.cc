@@ -0,0 +1,115 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include "flatast.h"
+#include "parser.h"
+
+// Pointer AST against its flat form: bytes per tree, a full traversal
+// and JSON time for each. Exits with 1 if the two differ.
+
+static std::string makeSource(int functions) {
+    std::string source;
+    for (int i = 0; i < functions; i++) {
+        const std::string n = std::to_string(i);
+        source += "func compute_" + n + "(alpha: i32, beta: f64[]) i32 {\n";
+        source += "    var total: i32 = alpha * 0x1F + 3.25e-2;\n";
+        source += "    while (total <= 1000 && beta != null) {\n";
+        source += "        total += alpha << 2 | 1;\n";
+        source += "        if (alpha >= total) { break; } else { continue; }\n";
+        source += "    }\n";
+        source += "    var parts = [\"result\", \"of " + n + "\\n\", $total];\n";
+        source += "    total = total > 0 ? print(parts, total) : 0;\n";
+        source += "    return total;\n";
+        source += "}\n";
+    }
+    return source;
+}
+
+// Literals per kind through the visitor, children through forEachChild.
+class LiteralCounter : public Visitor<LiteralCounter> {
+  public:
+    long nodes = 0, literals = 0;
+
+    void visitNode(Node* node) {
+        nodes++;
+        forEachChild(node, [this](Node* child) { visit(child); });
+    }
+
+    void visitNumberLiteral(NumberLiteral*) {
+        nodes++;
+        literals++;
+    }
+
+    void visitStringLiteral(StringLiteral*) {
+        nodes++;
+        literals++;
+    }
+};
+
+static long countFlat(const FlatView& tree, NodeId id) {
+    long nodes = 1;
+    forEachChild(tree, id,
+                 [&](NodeId child) { nodes += countFlat(tree, child); });
+    return nodes;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+int main(int argc, char** argv) {
+    const int functions = argc > 1 ? atoi(argv[1]) : 20000;
+    const std::string source = makeSource(functions);
+
+    Lexer lexer(source);
+    ParseContext context;
+    Parser parser(&lexer, &context);
+    Node* root = parser.parse();
+
+    auto start = std::chrono::steady_clock::now();
+    FlatTree flat(root);
+    const double flattenTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    LiteralCounter counter;
+    counter.visit(root);
+    const double pointerWalk = since(start);
+
+    start = std::chrono::steady_clock::now();
+    const long flatNodes = countFlat(flat.view(), flat.root);
+    const double flatWalk = since(start);
+
+    start = std::chrono::steady_clock::now();
+    const std::string pointerJSON = root->toJSON();
+    const double pointerTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    const std::string flatJSON = flat.toJSON();
+    const double flatTime = since(start);
+
+    const size_t flatBytes = flat.words.size() * sizeof(uint32_t) +
+                             flat.children.size() * sizeof(NodeId) +
+                             flat.strings.size() +
+                             flat.symbols.size() * sizeof(Symbol);
+    std::printf("flat: %zu bytes of source, pointer tree %zu bytes, "
+                "flat tree %zu bytes (%.2fx)\n",
+                source.size(), context.arena.bytesUsed(), flatBytes,
+                (double)context.arena.bytesUsed() / flatBytes);
+    std::printf("flat: %ld nodes (%ld literals), walk pointer %.3fs, "
+                "flat %.3fs\n",
+                counter.nodes, counter.literals, pointerWalk, flatWalk);
+    std::printf("flat: flatten %.3fs, toJSON pointer %.3fs, flat %.3fs\n",
+                flattenTime, pointerTime, flatTime);
+
+    if (pointerJSON != flatJSON || counter.nodes != flatNodes) {
+        std::printf("flat: MISMATCH\n");
+        return 1;
+    }
+    return 0;
+}
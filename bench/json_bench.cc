@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include <fcntl.h>
+
+#include "ast.h"
+
+// JSON bytes per second on a deep tree (one long chain of binary
+// operators) and a wide one (a block of many short statements): the old
+// per-node string concatenation, writeJSON into memory and writeJSON
+// streamed to /dev/null. Exits with 1 if the outputs differ.
+
+// What the generated toJSON() used to do, for the kinds the trees use.
+class ConcatJSON : public Visitor<ConcatJSON, std::string> {
+  public:
+    std::string child(Node* node) {
+        return node ? visit(node) : "null";
+    }
+
+    std::string visitBinaryOperator(BinaryOperator* node) {
+        return "{\"_type\": \"BinaryOperator\",\"left\": " + child(node->left) +
+               ",\"right\": " + child(node->right) + ",\"op\": \"" +
+               Lexer::getTokenStr(node->op) + "\"}";
+    }
+
+    std::string visitNumberLiteral(NumberLiteral* node) {
+        return "{\"_type\": \"NumberLiteral\",\"literal\": \"" +
+               std::string(node->literal) + "\"}";
+    }
+
+    std::string visitExpressionStatement(ExpressionStatement* node) {
+        return "{\"_type\": \"ExpressionStatement\",\"expression\": " +
+               child(node->expression) + "}";
+    }
+
+    std::string visitBlock(Block* node) {
+        std::string result = "[";
+        for (size_t i = 0; i < node->statements.size(); i++) {
+            result += child(node->statements[i]);
+            if (i < node->statements.size() - 1) result += ", ";
+        }
+        return "{\"_type\": \"Block\",\"statements\": " + result + "]}";
+    }
+};
+
+static Node* makeDeep(Arena& arena, int depth) {
+    Node* node = NumberLiteral::create(arena, "0");
+    for (int i = 1; i < depth; i++)
+        node = BinaryOperator::create(
+                arena, NumberLiteral::create(arena, std::to_string(i)), node,
+                '+');
+    return node;
+}
+
+static Node* makeWide(Arena& arena, int width) {
+    std::vector<Node*> statements;
+    for (int i = 0; i < width; i++) {
+        Node* sum = BinaryOperator::create(
+                arena, NumberLiteral::create(arena, std::to_string(i)),
+                NumberLiteral::create(arena, "1"), '+');
+        statements.push_back(ExpressionStatement::create(arena, sum));
+    }
+    return Block::create(arena, statements);
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+static bool run(const char* name, Node* root) {
+    auto start = std::chrono::steady_clock::now();
+    const std::string concat = ConcatJSON().visit(root);
+    const double concatTime = since(start);
+
+    start = std::chrono::steady_clock::now();
+    JsonWriter memory;
+    root->writeJSON(memory);
+    const double memoryTime = since(start);
+
+    const int fd = open("/dev/null", O_WRONLY);
+    start = std::chrono::steady_clock::now();
+    size_t streamed;
+    {
+        JsonWriter stream(fd);
+        root->writeJSON(stream);
+        stream.flush();
+        streamed = stream.bytesWritten();
+    }
+    const double streamTime = since(start);
+    close(fd);
+
+    const double mb = memory.bytesWritten() / 1e6;
+    std::printf("json %s: %zu bytes, concat %.1f MB/s, writer %.1f MB/s, "
+                "streamed %.1f MB/s\n",
+                name, memory.bytesWritten(), mb / concatTime, mb / memoryTime,
+                mb / streamTime);
+    return concat == memory.view() && streamed == memory.bytesWritten();
+}
+
+int main(int argc, char** argv) {
+    const int depth = argc > 1 ? atoi(argv[1]) : 5000;
+    const int width = argc > 2 ? atoi(argv[2]) : 500000;
+
+    Arena arena;
+    bool same = run("deep", makeDeep(arena, depth));
+    same = run("wide", makeWide(arena, width)) && same;
+
+    if (!same) {
+        std::printf("json: MISMATCH\n");
+        return 1;
+    }
+    return 0;
+}
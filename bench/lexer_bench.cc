@@ -0,0 +1,54 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include "lexer.h"
+
+// Lexer throughput benchmark: tokens/second over a synthetic source that
+// is identifier and keyword heavy, like our generated code.
+
+static std::string makeSource(int functions) {
+    std::string source;
+    for (int i = 0; i < functions; i++) {
+        const std::string n = std::to_string(i);
+        source += "// function number " + n + "\n";
+        source += "func compute_" + n + "(alpha: i32, beta: const f64[]) i32 {\n";
+        source += "    var total_" + n + ": i32 = alpha * 0x1F + 3.25e-2;\n";
+        source += "    while (total_" + n + " <= 1000 && beta != null) {\n";
+        source += "        total_" + n + " += alpha << 2;\n";
+        source += "        if (alpha >= beta) { break; } else { continue; }\n";
+        source += "    }\n";
+        source += "    let message = \"result of " + n + " is\\n\";\n";
+        source += "    return total_" + n + " >>= 1;\n";
+        source += "}\n";
+    }
+    return source;
+}
+
+int main(int argc, char** argv) {
+    const int functions = argc > 1 ? atoi(argv[1]) : 20000;
+    const int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    const std::string source = makeSource(functions);
+
+    long tokens = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        Lexer lex(source);
+        while (lex.tk) {
+            lex.getNextToken();
+            tokens++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::printf("lexer: %zu bytes x %d rounds, %ld tokens in %.3fs, "
+                "%.2f Mtokens/s, %.1f MB/s\n",
+                source.size(), rounds, tokens, seconds,
+                tokens / seconds / 1e6,
+                source.size() * (double)rounds / seconds / 1e6);
+    return 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include "lexer.h"
+
+// Load + lex time for a large file: the old istreambuf_iterator read plus
+// a private copy in the lexer, against a mapped SourceBuffer the lexer
+// borrows.
+
+static long lexAll(Lexer& lex) {
+    long tokens = 0;
+    while (lex.tk) {
+        lex.getNextToken();
+        tokens++;
+    }
+    return tokens;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+int main(int argc, char** argv) {
+    const long megabytes = argc > 1 ? atol(argv[1]) : 100;
+
+    char path[] = "/tmp/capstone_load_bench_XXXXXX";
+    const int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    std::string chunk;
+    for (int i = 0; i < 1000; i++)
+        chunk += "func f" + std::to_string(i) +
+                 "(a: i32) i32 { /* body */ return a * 2 + \"text\"; }\n";
+    size_t written = 0;
+    while (written < (size_t)megabytes << 20)
+        written += write(fd, chunk.data(), chunk.size());
+    close(fd);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::ifstream file(path);
+        const std::string text((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+        Lexer lex(text);
+        lexAll(lex);
+    }
+    const double copied = since(start);
+
+    start = std::chrono::steady_clock::now();
+    long tokens;
+    {
+        SourceBuffer* source = SourceBuffer::load(path);
+        Lexer lex(source);
+        tokens = lexAll(lex);
+        delete source;
+    }
+    const double mapped = since(start);
+
+    unlink(path);
+    std::printf("load+lex %zu bytes, %ld tokens: stream+copy %.3fs, "
+                "mmap %.3fs\n",
+                written, tokens, copied, mapped);
+    return 0;
+}
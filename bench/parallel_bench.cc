@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+#include <thread>
+
+#include "tokenbuffer.h"
+
+// Parallel against serial lexing. The corpus is full of newlines inside
+// strings and comments, quotes inside comments and comment markers inside
+// strings, so a bad split point shows up as a token mismatch. Exits with
+// 1 if any parallel run differs from the serial one.
+
+static std::string makeCorpus(long bytes) {
+    static const char* pieces[] = {
+            "func f(a: i32) i32 { return a * 2; }\n",
+            "var s = \"line one\nline two // not a comment\n/* nor this */\";\n",
+            "/* block with \"quote\nand 'single\n */ var x = 1;\n",
+            "// comment with \" and ' and /*\nvar y = x / 2;\n",
+            "let c = '\\x41'; let o = '\\101\\n'; let q = 'it\\'s';\n",
+            "let tricky = '\\x4'\n'; let more = \"esc \\\" quote\n\";\n",
+            "var z = a /* inline */ + b; var w = a/b;\n",
+            "/*/ still a comment\n*/ var v = 0x1F + 3.5e-2;\n",
+    };
+    std::string corpus;
+    for (unsigned i = 0; corpus.size() < (size_t)bytes; i = i * 7 + 3)
+        corpus += pieces[i % (sizeof(pieces) / sizeof(*pieces))];
+    return corpus;
+}
+
+static bool same(TokenBuffer& a, TokenBuffer& b) {
+    return a.kinds == b.kinds && a.offsets == b.offsets &&
+           a.lengths == b.lengths && a.symbols == b.symbols;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+int main(int argc, char** argv) {
+    const long bytes = (argc > 1 ? atol(argv[1]) : 64) << 20;
+    std::string corpus = makeCorpus(bytes);
+    std::string withNul = corpus;
+    withNul[withNul.size() * 3 / 5] = 0;
+
+    int failures = 0;
+    for (const std::string* input : {&corpus, &withNul}) {
+        SourceBuffer source(*input);
+
+        auto start = std::chrono::steady_clock::now();
+        Lexer serialLexer(&source);
+        TokenBuffer serial(&serialLexer);
+        serial.tokenize();
+        const double serialTime = since(start);
+        std::printf("parallel %s: %zu bytes, %zu tokens, serial %.3fs\n",
+                    input == &corpus ? "corpus" : "with NUL", input->size(),
+                    serial.kinds.size(), serialTime);
+
+        for (int threads = 2; threads <= 16; threads *= 2) {
+            start = std::chrono::steady_clock::now();
+            Lexer lexer(&source);
+            TokenBuffer parallel(&lexer);
+            parallel.tokenizeParallel(threads);
+            const double time = since(start);
+            const bool ok = same(serial, parallel);
+            failures += !ok;
+            std::printf("    %2d threads: %.3fs (%.2fx) %s\n", threads, time,
+                        serialTime / time, ok ? "identical" : "MISMATCH");
+        }
+    }
+    std::printf("    (%u hardware threads)\n",
+                std::thread::hardware_concurrency());
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include "parser.h"
+
+// Parse time of a clean corpus against the same corpus with a syntax error
+// in every tenth function. Exits with 1 if the broken one does not report
+// exactly one diagnostic per error, or the clean one reports any.
+
+static std::string makeSource(int functions, bool broken) {
+    std::string source;
+    for (int i = 0; i < functions; i++) {
+        const std::string n = std::to_string(i);
+        const bool bad = broken && i % 10 == 5;
+        source += "func step_" + n + "(a: i32, b: i32) i32 {\n";
+        source += "    var total: i32 = a * 3 + b;\n";
+        source += "    while (total < 100) { total += b << 1; }\n";
+        if (bad)
+            source += "    var lost: = total;\n";
+        else
+            source += "    var kept: i32 = total;\n";
+        source += "    return total;\n";
+        source += "}\n";
+    }
+    return source;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+static size_t parse(const std::string& source, double& time) {
+    Lexer lexer(source);
+    TokenBuffer tokens(&lexer);
+    tokens.tokenize();
+    ParseContext context;
+    context.diagnostics.limit = SIZE_MAX;
+    auto start = std::chrono::steady_clock::now();
+    Parser parser(&tokens, &context);
+    parser.parse();
+    time = since(start);
+    return context.diagnostics.count();
+}
+
+int main(int argc, char** argv) {
+    const int functions = argc > 1 ? atoi(argv[1]) : 50000;
+
+    double cleanTime, brokenTime;
+    const size_t clean = parse(makeSource(functions, false), cleanTime);
+    const size_t broken = parse(makeSource(functions, true), brokenTime);
+    const size_t expected = (functions + 4) / 10;
+
+    std::printf("recover: %d functions, clean %.3fs, %zu errors %.3fs "
+                "(%.2fx)\n",
+                functions, cleanTime, broken, brokenTime,
+                brokenTime / cleanTime);
+
+    if (clean != 0 || broken != expected) {
+        std::printf("recover: expected %zu errors, got %zu\n", expected,
+                    broken);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <algorithm>
+#include <chrono>
+
+#include "tokenbuffer.h"
+
+// Incremental relexing after random small edits against lexing the edited
+// source from scratch. Every edit is checked against the full relex and
+// the run exits with 1 on the first mismatch.
+
+static const char* snippets[] = {
+        "x", " ", "\n", "\"", "'", "/*", "*/", "//", "\\", "<", "=", ">",
+        "0x1", "1.5e-", "var ", "func ", "\"str\\n\"", "{", "}", ";",
+};
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+int main(int argc, char** argv) {
+    const int edits = argc > 1 ? atoi(argv[1]) : 2000;
+    std::string text;
+    for (int i = 0; text.size() < (8 << 20); i++)
+        text += "func f" + std::to_string(i) +
+                "(a: i32) i32 {\n    // step\n    var s = \"v\\n\" + 'c';\n"
+                "    /* note */ return a << 2 >= 0x1F ? a : 1.5e-3;\n}\n";
+
+    SourceBuffer* source = new SourceBuffer(text);
+    Lexer* lexer = new Lexer(source);
+    TokenBuffer tokens(lexer);
+    tokens.tokenize();
+
+    srand(7);
+    std::vector<int> relexed;
+    std::vector<double> incremental;
+    double full = 0;
+    for (int e = 0; e < edits; e++) {
+        const int offset = rand() % source->size;
+        const int removed = std::min(rand() % 4, source->size - offset);
+        const std::string_view inserted =
+                snippets[rand() % (sizeof(snippets) / sizeof(*snippets))];
+
+        SourceBuffer* edited = source->edit(offset, removed, inserted);
+        Lexer* editedLexer = new Lexer(edited);
+
+        auto start = std::chrono::steady_clock::now();
+        relexed.push_back(
+                tokens.relex(editedLexer, offset, removed, inserted.size()));
+        incremental.push_back(since(start));
+
+        start = std::chrono::steady_clock::now();
+        Lexer fullLexer(edited);
+        TokenBuffer reference(&fullLexer);
+        reference.tokenize();
+        full += since(start);
+
+        if (tokens.kinds != reference.kinds ||
+            tokens.offsets != reference.offsets ||
+            tokens.lengths != reference.lengths ||
+            tokens.symbols != reference.symbols) {
+            std::printf("relex: MISMATCH after edit %d at %d\n", e, offset);
+            return 1;
+        }
+
+        delete lexer;
+        delete source;
+        lexer = editedLexer;
+        source = edited;
+    }
+
+    // medians, an inserted quote or comment opener legitimately relexes
+    // everything up to the next point where the streams realign
+    std::sort(relexed.begin(), relexed.end());
+    std::sort(incremental.begin(), incremental.end());
+    std::printf("relex: %d edits on %d bytes, median %d tokens and %.1fus "
+                "per edit (p90 %.1fus) vs %.1fms full relex\n",
+                edits, source->size, relexed[edits / 2],
+                incremental[edits / 2] * 1e6,
+                incremental[edits * 9 / 10] * 1e6, full / edits * 1e3);
+    return 0;
+}
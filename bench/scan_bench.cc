@@ -0,0 +1,73 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include "lexer.h"
+
+// Lexer throughput on comment-heavy and string-heavy sources for each scan
+// kernel level the CPU supports.
+
+static std::string makeComments(int blocks) {
+    std::string source;
+    const std::string rule(76, '*');
+    for (int i = 0; i < blocks; i++) {
+        source += "/" + rule + "\n";
+        for (int j = 0; j < 6; j++)
+            source += " * Generated banner line " + std::to_string(j) +
+                      " for block " + std::to_string(i) +
+                      ", do not edit by hand.\n";
+        source += " " + rule + "/\n";
+        source += "// -------------------------------------------------------\n";
+        source += "var banner_" + std::to_string(i) + " = 0;\n\n";
+    }
+    return source;
+}
+
+static std::string makeStrings(int rows) {
+    std::string source = "var table = [\n";
+    for (int i = 0; i < rows; i++)
+        source += "    \"row " + std::to_string(i) +
+                  ": the quick brown fox jumps over the lazy dog again\",\n"
+                  "    \"identifier_with_a_fairly_long_name_" +
+                  std::to_string(i) + "\",\n";
+    return source + "];\n";
+}
+
+static double lexSeconds(const std::string& source, int rounds, long& tokens) {
+    tokens = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        Lexer lex(source);
+        while (lex.tk) {
+            lex.getNextToken();
+            tokens++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+    const int rounds = argc > 1 ? atoi(argv[1]) : 5;
+    const std::pair<const char*, std::string> inputs[] = {
+            {"comments", makeComments(20000)},
+            {"strings", makeStrings(50000)},
+    };
+
+    for (const auto& input : inputs) {
+        for (int level = SCAN_SCALAR; level <= scanSupported(); level++) {
+            scanUse(level);
+            long tokens;
+            const double seconds = lexSeconds(input.second, rounds, tokens);
+            std::printf("scan %-8s %-6s: %zu bytes, %.1f MB/s, "
+                        "%.2f Mtokens/s\n",
+                        input.first, scanLevelName(level), input.second.size(),
+                        input.second.size() * (double)rounds / seconds / 1e6,
+                        tokens / seconds / 1e6);
+        }
+    }
+    return 0;
+}
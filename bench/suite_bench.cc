@@ -0,0 +1,122 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+
+#include <sys/resource.h>
+
+#include "corpus.h"
+#include "parser.h"
+#include "utils.h"
+
+// Front end throughput on a generated corpus: tokens/s for the lexer,
+// nodes/s for the parser and bytes/s for JSON output, best of a few runs
+// each, plus the peak RSS of the process. The results are also written as
+// JSON, next to the binary unless a path is given, so runs can be compared.
+//
+// suite_bench [megabytes] [seed] [results.json]
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+static long countNodes(Node* node) {
+    long nodes = 1;
+    forEachChild(node, [&](Node* child) { nodes += countNodes(child); });
+    return nodes;
+}
+
+static void field(JsonWriter& out, const char* name, double value,
+                  bool last = false) {
+    char number[64];
+    snprintf(number, sizeof(number), "%.15g", value);
+    out.write("\"");
+    out.write(name);
+    out.write("\": ");
+    out.write(number);
+    if (!last) out.write(", ");
+}
+
+int main(int argc, char** argv) {
+    CorpusGenerator::Options options;
+    options.bytes = (argc > 1 ? atol(argv[1]) : 16) << 20;
+    options.seed = argc > 2 ? atol(argv[2]) : 1;
+    const std::string resultsPath =
+            argc > 3 ? argv[3] : std::string(argv[0]) + ".json";
+    const int runs = 3;
+
+    auto start = std::chrono::steady_clock::now();
+    const std::string source = CorpusGenerator(options).generate();
+    const double generateTime = since(start);
+
+    double lexTime = 1e30, parseTime = 1e30, jsonTime = 1e30;
+    size_t tokens = 0, jsonBytes = 0, errors = 0;
+    long nodes = 0;
+    for (int run = 0; run < runs; run++) {
+        Lexer lexer(source);
+        TokenBuffer buffer(&lexer);
+        start = std::chrono::steady_clock::now();
+        buffer.tokenize();
+        lexTime = std::min(lexTime, since(start));
+        tokens = buffer.size();
+
+        ParseContext context;
+        Parser parser(&buffer, &context);
+        start = std::chrono::steady_clock::now();
+        Node* root = parser.parse();
+        parseTime = std::min(parseTime, since(start));
+        nodes = countNodes(root);
+        errors = context.diagnostics.count();
+
+        JsonWriter json;
+        start = std::chrono::steady_clock::now();
+        root->writeJSON(json);
+        jsonTime = std::min(jsonTime, since(start));
+        jsonBytes = json.bytesWritten();
+    }
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    const double peakRss = usage.ru_maxrss * 1024.0;
+
+    std::printf("suite: %zu bytes of source generated in %.3fs\n",
+                source.size(), generateTime);
+    std::printf("suite: lex %zu tokens %.3fs (%.1f M tokens/s)\n", tokens,
+                lexTime, tokens / lexTime / 1e6);
+    std::printf("suite: parse %ld nodes %.3fs (%.1f M nodes/s)\n", nodes,
+                parseTime, nodes / parseTime / 1e6);
+    std::printf("suite: json %zu bytes %.3fs (%.1f MB/s)\n", jsonBytes,
+                jsonTime, jsonBytes / jsonTime / 1e6);
+    std::printf("suite: peak RSS %.1f MB\n", peakRss / 1e6);
+
+    JsonWriter out;
+    out.write("{\"corpus\": {");
+    field(out, "bytes", source.size());
+    field(out, "seed", options.seed, true);
+    out.write("}, \"lex\": {");
+    field(out, "seconds", lexTime);
+    field(out, "tokens", tokens);
+    field(out, "tokensPerSecond", tokens / lexTime, true);
+    out.write("}, \"parse\": {");
+    field(out, "seconds", parseTime);
+    field(out, "nodes", nodes);
+    field(out, "nodesPerSecond", nodes / parseTime, true);
+    out.write("}, \"json\": {");
+    field(out, "seconds", jsonTime);
+    field(out, "bytes", jsonBytes);
+    field(out, "bytesPerSecond", jsonBytes / jsonTime, true);
+    out.write("}, ");
+    field(out, "peakRssBytes", peakRss, true);
+    out.write("}\n");
+    dumpStringToFile(resultsPath, out.view());
+
+    if (errors) {
+        std::printf("suite: the corpus has %zu syntax errors\n", errors);
+        return 1;
+    }
+    return 0;
+}
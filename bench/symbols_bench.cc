@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+#include <thread>
+
+#include "symbols.h"
+
+// Interning throughput with several threads hammering one table over a
+// shared set of a few thousand names, the way parallel lexers would. Every
+// thread checks that each name maps to the same id the first pass gave it
+// and that the id maps back to the name. Exits with 1 on any mismatch.
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+int main(int argc, char** argv) {
+    const int threads = argc > 1 ? atoi(argv[1]) : 4;
+    const int rounds = argc > 2 ? atoi(argv[2]) : 2000;
+
+    std::vector<std::string> names;
+    for (int i = 0; i < 4096; i++)
+        names.push_back((i % 3 ? "value" : "TypeName") +
+                        std::to_string(i * 7919));
+
+    SymbolTable table;
+    std::vector<Symbol> ids;
+    for (const std::string& name : names) ids.push_back(table.intern(name));
+
+    std::vector<int> failures(threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]() {
+            for (int r = 0; r < rounds; r++)
+                for (size_t i = t; i < names.size(); i += 1 + r % 3) {
+                    const Symbol id = table.intern(names[i]);
+                    if (id != ids[i] || table.name(id) != names[i])
+                        failures[t]++;
+                }
+            // fresh names from every thread at once
+            for (int i = 0; i < 10000; i++) {
+                const std::string name = "t" + std::to_string(t) + "_" +
+                                         std::to_string(i);
+                if (table.name(table.intern(name)) != name) failures[t]++;
+            }
+        });
+    for (std::thread& worker : workers) worker.join();
+    const double time = since(start);
+
+    long total = 0;
+    for (int t = 0; t < threads; t++)
+        for (int r = 0; r < rounds; r++) total += names.size() / (1 + r % 3);
+    std::printf("symbols: %d threads, %zu distinct, %.1f M interns/s\n",
+                threads, table.size(), total / time / 1e6);
+
+    int failed = 0;
+    for (int count : failures) failed += count;
+    if (table.size() != 1 + names.size() + 10000 * (size_t)threads) failed++;
+    if (failed) {
+        std::printf("symbols: MISMATCH (%d)\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,423 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include <pthread.h>
+
+#include "parser.h"
+
+// Looks for inputs whose cost in the lexer, parser and JSON writer grows
+// faster than their size. An input is a template: backticks split it into
+// parts, and every second part is repeated n times, so "f(`f(`1`)`)" grows
+// into n nested calls and an input without backticks is repeated whole.
+// Each input is run at three sizes and the growth of its tokens, arena
+// bytes, JSON bytes and time is fitted to size^k between each pair; a k
+// well above 1 at both steps means super-linear work and the input is
+// saved. A single step is not enough: an input can change shape as it
+// grows, when the parser gives up or a quote or comment stops pairing up.
+//
+// Built with -fsanitize=fuzzer and -DCAPSTONE_LIBFUZZER this is a libFuzzer
+// target that aborts on such an input, so libFuzzer keeps it as a crash.
+// Built without, main() runs the seed corpus and then mutates it for a
+// while, keeping the mutants that grow fastest:
+//
+// perf_fuzz [--seconds N] [--timeout N] [--artifacts dir] [--seed N] corpus...
+//
+// An input that takes longer than --timeout seconds to measure is saved
+// as a finding and ends the run, since its growth may never be known.
+
+// marks the parts of a template that are repeated
+static const char REPEAT = '`';
+
+// exponents above these are reported; time is noisy and gets more room
+static const double maxWorkExponent = 1.25;
+static const double maxTimeExponent = 1.6;
+// time is only compared once the larger run takes this long
+static const double minSeconds = 0.002;
+// inputs are not grown past this
+static const size_t maxBytes = 1 << 20;
+
+struct Cost {
+    double seconds = 0;
+    size_t tokens = 0;
+    size_t arenaBytes = 0;
+    size_t jsonBytes = 0;
+};
+
+struct Growth {
+    size_t smallBytes = 0, largeBytes = 0;
+    double tokens = 0, arena = 0, json = 0, time = 0;
+
+    // how close the input comes to being reported, 0 at the limits
+    double worst(void) const {
+        return std::max({tokens - maxWorkExponent, arena - maxWorkExponent,
+                         json - maxWorkExponent, time - maxTimeExponent});
+    }
+    bool superLinear(void) const {
+        return tokens > maxWorkExponent || arena > maxWorkExponent ||
+               json > maxWorkExponent || time > maxTimeExponent;
+    }
+};
+
+static std::string expand(const std::string& input, size_t times) {
+    std::vector<std::string> parts(1);
+    for (char c : input) {
+        if (c == REPEAT)
+            parts.emplace_back();
+        else
+            parts.back() += c;
+    }
+    if (parts.size() == 1) parts = {"", input};
+
+    std::string out;
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (i % 2 == 0) {
+            out += parts[i];
+        } else {
+            for (size_t n = 0; n < times && out.size() < maxBytes; n++)
+                out += parts[i];
+        }
+    }
+    return out;
+}
+
+static double since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+// The parser and the JSON writer recurse once per level of nesting, so
+// the largest nested inputs need far more than the default stack. Depth
+// is not what this harness looks for, so work runs on a thread with a
+// stack big enough for any input it builds.
+static void* runWork(void* work) {
+    (*(std::function<void()>*)work)();
+    return nullptr;
+}
+
+static void onLargeStack(std::function<void()> work) {
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, (size_t)1 << 30);
+    pthread_t thread;
+    if (pthread_create(&thread, &attributes, runWork, &work) == 0)
+        pthread_join(thread, nullptr);
+    else
+        work();
+    pthread_attr_destroy(&attributes);
+}
+
+// One pass of the driver's front end, best time of a few.
+static Cost measure(const std::string& source) {
+    Cost cost;
+    cost.seconds = 1e30;
+    for (int run = 0; run < 3; run++) {
+        auto start = std::chrono::steady_clock::now();
+        try {
+            Lexer lexer(source);
+            TokenBuffer tokens(&lexer);
+            tokens.tokenize();
+            ParseContext context;
+            Parser parser(&tokens, &context);
+            Node* root = parser.parse();
+            cost.tokens = parser.peeks;
+            cost.arenaBytes = context.arena.bytesUsed();
+
+            JsonWriter json;
+            if (root) root->writeJSON(json);
+            for (const std::string& message : context.diagnostics.messages)
+                json.writeEscaped(message);
+            cost.jsonBytes = json.bytesWritten();
+        } catch (Exception* e) {
+            delete e;
+        }
+        cost.seconds = std::min(cost.seconds, since(start));
+        // a single fast run says nothing more than three, and a slow one
+        // is already a clear signal
+        if (cost.seconds < minSeconds / 8 || cost.seconds > 1) break;
+    }
+    return cost;
+}
+
+static double exponent(double small, double large, double ratio) {
+    if (small <= 0 || large <= small) return 0;
+    return std::log(large / small) / std::log(ratio);
+}
+
+static Growth step(const std::string& small, const Cost& a,
+                   const std::string& large, const Cost& b) {
+    Growth growth;
+    growth.smallBytes = small.size();
+    growth.largeBytes = large.size();
+    if (large.size() <= small.size()) return growth;
+    const double ratio = (double)large.size() / small.size();
+    growth.tokens = exponent(a.tokens, b.tokens, ratio);
+    growth.arena = exponent(a.arenaBytes, b.arenaBytes, ratio);
+    growth.json = exponent(a.jsonBytes, b.jsonBytes, ratio);
+    if (b.seconds >= minSeconds)
+        growth.time = exponent(a.seconds, b.seconds, ratio);
+    return growth;
+}
+
+// Runs the input grown to roughly 64K, 4 and 8 times that, or as large as
+// it gets under maxBytes, and keeps the smaller exponent of the two steps.
+// Repeat counts are multiples of 4 so that parts with an odd number of
+// quotes or comment marks pair up the same way at every size.
+static Growth grow(const std::string& input) {
+    // bytes added by each repeat
+    const size_t unit = std::max<size_t>(
+            expand(input, 2).size() - expand(input, 1).size(), 1);
+    const size_t times = (std::max<size_t>(65536 / unit, 1) + 3) & ~3;
+    const std::string small = expand(input, times);
+    const std::string middle = expand(input, times * 4);
+    const std::string large = expand(input, times * 8);
+    Cost a, b, c;
+    onLargeStack([&]() {
+        a = measure(small);
+        b = measure(middle);
+        c = measure(large);
+    });
+
+    const Growth first = step(small, a, middle, b);
+    const Growth second = step(middle, b, large, c);
+    Growth growth;
+    growth.smallBytes = small.size();
+    growth.largeBytes = large.size();
+    growth.tokens = std::min(first.tokens, second.tokens);
+    growth.arena = std::min(first.arena, second.arena);
+    growth.json = std::min(first.json, second.json);
+    growth.time = std::min(first.time, second.time);
+    return growth;
+}
+
+static void report(FILE* out, const char* what, const Growth& growth) {
+    std::fprintf(out,
+                 "%s: %zu -> %zu bytes, exponents tokens %.2f arena %.2f "
+                 "json %.2f time %.2f\n",
+                 what, growth.smallBytes, growth.largeBytes, growth.tokens,
+                 growth.arena, growth.json, growth.time);
+}
+
+#ifdef CAPSTONE_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const Growth growth = grow(std::string((const char*)data, size));
+    if (growth.superLinear()) {
+        report(stderr, "super-linear", growth);
+        abort();
+    }
+    return 0;
+}
+
+#else
+
+static uint32_t fnv1a(const std::string& text) {
+    uint32_t hash = 0x811c9dc5;
+    for (char c : text) hash = (hash ^ (uint8_t)c) * 0x01000193;
+    return hash;
+}
+
+// Pieces of the language mutations insert, so that most mutants still lex.
+static const char* dictionary[] = {
+        "`",      "{",       "}",     "(",     ")",       "[",     "]",
+        ";",      ",",       ".",     ":",     "?",       "<",     ">",
+        "\"",     "\\n",     "\\\"",  "\\\\",  "\n",      " ",     "+",
+        "*",      "==",      "&&",    "!",     "$",       "//",    "/*",
+        "*/",     "0x1F",    "1.5e3", "name",  "func ",   "var ",  "let ",
+        "const ", "class ",  "if ",   "else ", "while ",  "for ",  "return ",
+        "import ", "enum ",  "i32",   "String", "List<",  "null",  "true"};
+
+class Mutator {
+  public:
+    Mutator(uint64_t seed) : random(seed) {}
+
+    std::string mutate(const std::string& input, const std::string& other) {
+        std::string out = input;
+        const int steps = 1 + roll(4);
+        for (int i = 0; i < steps; i++) {
+            const size_t at = out.empty() ? 0 : roll(out.size() + 1);
+            switch (roll(5)) {
+            case 0:
+                out.insert(at, dictionary[roll(sizeof(dictionary) /
+                                               sizeof(*dictionary))]);
+                break;
+            case 1:
+                if (!out.empty()) out.erase(at, 1 + roll(8));
+                break;
+            case 2:
+                if (at < out.size()) out[at] = ' ' + roll(95);
+                break;
+            case 3:
+                if (!out.empty()) {
+                    const size_t from = roll(out.size());
+                    out.insert(at, out.substr(from, 1 + roll(16)));
+                }
+                break;
+            default:
+                if (!other.empty()) {
+                    const size_t from = roll(other.size());
+                    out.insert(at, other.substr(from, 1 + roll(32)));
+                }
+            }
+        }
+        if (out.size() > 4096) out.resize(4096);
+        return out;
+    }
+
+  private:
+    std::mt19937_64 random;
+
+    size_t roll(size_t n) {
+        return random() % n;
+    }
+};
+
+static bool save(const std::string& dir, const std::string& input,
+                 const char* prefix = "slow") {
+    std::filesystem::create_directories(dir);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s-%08x.cap", prefix, fnv1a(input));
+    const std::string path = dir + "/" + name;
+    std::ofstream(path, std::ios::binary) << input;
+    std::printf("saved %s\n", path.c_str());
+    return true;
+}
+
+// Watches the input being grown from a thread of its own. The work cannot
+// be interrupted, so an input past the limit is saved and the process
+// exits, the way libFuzzer treats a timeout.
+class Watchdog {
+  public:
+    Watchdog(const std::string& artifacts, double limit)
+        : artifacts(artifacts), limit(limit) {
+        std::thread([this]() { watch(); }).detach();
+    }
+
+    void start(const std::string& input) {
+        std::lock_guard<std::mutex> guard(lock);
+        current = input;
+        started = std::chrono::steady_clock::now();
+        running = true;
+    }
+
+    void stop(void) {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+    }
+
+  private:
+    const std::string artifacts;
+    const double limit;
+    std::mutex lock;
+    std::string current;
+    std::chrono::steady_clock::time_point started;
+    bool running = false;
+
+    void watch(void) {
+        for (;;) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::lock_guard<std::mutex> guard(lock);
+            if (!running || since(started) < limit) continue;
+            std::printf("timeout: input took more than %.0fs\n", limit);
+            save(artifacts, current, "timeout");
+            std::fflush(stdout);
+            std::_Exit(1);
+        }
+    }
+};
+
+int main(int argc, char** argv) {
+    double seconds = 60;
+    double timeout = 10;
+    std::string artifacts = "slow";
+    uint64_t seed = 1;
+    std::vector<std::string> corpus, names;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--seconds" && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (arg == "--timeout" && i + 1 < argc)
+            timeout = atof(argv[++i]);
+        else if (arg == "--artifacts" && i + 1 < argc)
+            artifacts = argv[++i];
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = strtoull(argv[++i], nullptr, 10);
+        else if (std::filesystem::is_directory(arg)) {
+            std::vector<std::string> found;
+            for (auto& entry : std::filesystem::directory_iterator(arg))
+                if (entry.is_regular_file())
+                    found.push_back(entry.path().string());
+            std::sort(found.begin(), found.end());
+            names.insert(names.end(), found.begin(), found.end());
+        } else {
+            names.push_back(arg);
+        }
+    }
+    if (names.empty()) {
+        std::printf("Usage: %s [--seconds N] [--timeout N] [--artifacts dir] "
+                    "[--seed N] <file | dir>...\n",
+                    argv[0]);
+        return 1;
+    }
+
+    Watchdog watchdog(artifacts, timeout);
+
+    // seeds first: any of them growing too fast is a regression
+    size_t slow = 0;
+    std::vector<double> scores;
+    for (const std::string& name : names) {
+        std::ifstream file(name, std::ios::binary);
+        std::string input((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+        watchdog.start(input);
+        const Growth growth = grow(input);
+        watchdog.stop();
+        report(stdout, name.c_str(), growth);
+        if (growth.superLinear()) slow += save(artifacts, input);
+        corpus.push_back(input);
+        scores.push_back(growth.worst());
+    }
+
+    // Then mutate: a mutant that grows faster than the input it came from
+    // joins the corpus, so the search climbs towards the slowest shapes.
+    Mutator mutator(seed);
+    std::mt19937_64 pick(seed);
+    const auto start = std::chrono::steady_clock::now();
+    size_t runs = 0;
+    while (since(start) < seconds) {
+        const size_t parent = pick() % corpus.size();
+        const std::string input = mutator.mutate(
+                corpus[parent], corpus[pick() % corpus.size()]);
+        watchdog.start(input);
+        const Growth growth = grow(input);
+        runs++;
+        if (growth.superLinear()) {
+            // measured again, a single noisy timing is not a finding
+            const Growth again = grow(input);
+            if (again.superLinear()) {
+                report(stdout, "super-linear", again);
+                slow += save(artifacts, input);
+            }
+        } else if (growth.worst() > scores[parent] + 0.02) {
+            corpus.push_back(input);
+            scores.push_back(growth.worst());
+        }
+        watchdog.stop();
+    }
+
+    std::printf("perf_fuzz: %zu seeds, %zu mutants in %.0fs, corpus %zu, "
+                "%zu super-linear\n",
+                names.size(), runs, since(start), corpus.size(), slow);
+    return slow ? 1 : 0;
+}
+
+#endif
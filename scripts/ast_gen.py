@@ -8,12 +8,33 @@
 
 type_map = {
     'node': 'Node*',
-    'nodes': 'std::vector<Node*>',
+    'nodes': 'NodeList',
     'token': 'int',
-    'string': 'std::string',
+    'string': 'std::string_view',
+    'symbol': 'Symbol',
     'count': 'unsigned int'
 }
 
+# What the create() factories take for each field type
+param_map = {
+    'NodeList': 'const std::vector<Node*>&',
+}
+
+# What the flat accessors return for each field type
+flat_map = {
+    'Node*': 'NodeId',
+    'NodeList': 'FlatRange',
+}
+
+# Field types that take two words in a flat record
+wide_types = ['NodeList', 'std::string_view']
+
+def fnv1a(text):
+    hash = 0x811c9dc5
+    for byte in text.encode():
+        hash = ((hash ^ byte) * 0x01000193) & 0xffffffff
+    return hash
+
 class Element:
     def __init__(self, name, type):
         self.name = name
@@ -30,15 +51,26 @@ class Node:
     def __str__(self):
         return f"{self.name}({', '.join(str(e) for e in self.elements)})"
     def params(self):
-        params = []
+        return ', '.join([f'{e.type} {e.name}' for e in self.elements])
+    def createParams(self):
+        params = ['Arena& arena']
+        for element in self.elements:
+            type = param_map.get(element.type, element.type)
+            params.append(f'{type} {element.name}')
+        return ', '.join(params)
+    def createArgs(self):
+        args = []
         for element in self.elements:
             if element.type == type_map['string']:
-                params.append(f'const {element.type}& {element.name}')
+                args.append(f'arena.copy({element.name})')
+            elif element.type == type_map['nodes']:
+                args.append(f'NodeList(arena, {element.name})')
             else:
-                params.append(f'{element.type} {element.name}')
-        return ', '.join(params)
+                args.append(element.name)
+        return ', '.join(args)
     def initialization(self):
-        return ', '.join([f'{e.name}({e.name})' for e in self.elements])
+        inits = [f'Node(NodeKind::{self.name})']
+        return ', '.join(inits + [f'{e.name}({e.name})' for e in self.elements])
     def group(self):
         groups = {}
         for element in self.elements:
@@ -55,33 +87,167 @@ class Node:
             body += f'{element.type} {element.name};\n    '
         return body
     def header(self):
-        init = self.initialization()
         return f'''class {self.name} : public Node {{
   public:              
     {self.fields()} 
-    {self.name}({self.params()}){' : ' if init != '' else ''}{self.initialization()} {{}}
-    std::string toJSON(void);
+    static {self.name}* create({self.createParams()});
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    {self.name}({self.params()}) : {self.initialization()} {{}}
 }};
 '''
-    def implementation(self):
-        json = f'"{{\\"_type\\": \\"{self.name}\\",'
+    def json(self, field, node, nodes, indent):
+        # field(name) is the C++ value of a field, node() and nodes() the
+        # statements that write a child and a child list. Adjacent literal
+        # text is merged into one write.
+        parts = [('text', f'{{"_type": "{self.name}"')]
         for element in self.elements:
+            value = field(element.name)
+            if element.type in [type_map['node'], type_map['nodes']]:
+                parts.append(('text', f',"{element.name}": '))
+            else:
+                parts.append(('text', f',"{element.name}": "'))
             if element.type == type_map['string']:
-                json += f'\\"{element.name}\\": \\"" + safeLiterals({element.name}) + "\\",'
+                parts.append(('code', f'out.writeEscaped({value});'))
+            elif element.type == type_map['symbol']:
+                parts.append(('code', f'out.writeEscaped(SymbolTable::global().name({value}));'))
             elif element.type == type_map['node']:
-                json += f'\\"{element.name}\\": " + nullSafeToString({element.name}) + ",'
+                parts.append(('code', node(value)))
             elif element.type == type_map['token']:
-                json += f'\\"{element.name}\\": \\"" + Lexer::getTokenStr({element.name}) + "\\",'
+                parts.append(('code', f'out.write(Lexer::getTokenStr({value}));'))
             elif element.type == type_map['nodes']:
-                json += f'\\"{element.name}\\": " + createList({element.name}) + ",'
+                parts.append(('code', nodes(value)))
             elif element.type == type_map['count']:
-                json += f'\\"{element.name}\\": \\"" + std::to_string({element.name}) + "\\",'
- 
-                
-        return f'''std::string {self.name}::toJSON(void) {{
-    return {json[:-1]}}}";
+                parts.append(('code', f'out.writeNumber({value});'))
+            if element.type not in [type_map['node'], type_map['nodes']]:
+                parts.append(('text', '"'))
+        parts.append(('text', '}'))
+        merged = []
+        for kind, text in parts:
+            if kind == 'text' and merged and merged[-1][0] == 'text':
+                merged[-1] = ('text', merged[-1][1] + text)
+            else:
+                merged.append((kind, text))
+        lines = []
+        for kind, text in merged:
+            if kind == 'text':
+                escaped = text.replace('"', '\\"')
+                lines.append(f'out.write("{escaped}");')
+            else:
+                lines.append(text)
+        return '\n'.join(indent + line for line in lines)
+    def implementation(self):
+        json = self.json(lambda name: name,
+                         lambda value: f'writeNode(out, {value});',
+                         lambda value: f'writeList(out, {value});',
+                         '    ')
+        return f'''{self.name}* {self.name}::create({self.createParams()}) {{
+    return ::new (arena.allocate(sizeof({self.name}), alignof({self.name}))) {self.name}({self.createArgs()});
+}}
+
+void {self.name}::writeJSON(JsonWriter& out) {{
+{json}
 }}'''
-        
+    def storage(self):
+        terms = []
+        for element in self.elements:
+            if element.type == type_map['nodes']:
+                terms.append(f'n->{element.name}.size() * sizeof(Node*)')
+            elif element.type == type_map['string']:
+                terms.append(f'n->{element.name}.size()')
+        if not terms:
+            return f'    case NodeKind::{self.name}: return 0;'
+        return f'''    case NodeKind::{self.name}: {{
+        auto n = static_cast<{self.name}*>(node);
+        return {' + '.join(terms)};
+    }}'''
+    def visitCase(self):
+        return f'''        case NodeKind::{self.name}:
+            return self().visit{self.name}(static_cast<{self.name}*>(node));'''
+    def visitDefault(self):
+        return f'''    Result visit{self.name}({self.name}* node) {{
+        return self().visitNode(node);
+    }}'''
+    def childCase(self, cast, node, nodes):
+        # cast is how to view the node, node() and nodes() how to walk a
+        # child and a child list
+        body = ''
+        for element in self.elements:
+            if element.type == type_map['node']:
+                body += f'        {node(element.name)}\n'
+            elif element.type == type_map['nodes']:
+                body += f'        {nodes(element.name)}\n'
+        if body == '':
+            return f'    case NodeKind::{self.name}: break;'
+        return f'''    case NodeKind::{self.name}: {{
+        {cast}
+{body}        break;
+    }}'''
+    def layout(self):
+        # word offset of each field in the flat record, after the kind
+        offsets, offset = [], 1
+        for element in self.elements:
+            offsets.append((element, offset))
+            offset += 2 if element.type in wide_types else 1
+        return offsets, offset - 1
+    def fieldCodes(self):
+        # what each field is to FlatFile::load(), see recordFields
+        codes = {type_map['node']: 'n', type_map['nodes']: 'l',
+                 type_map['string']: 's', type_map['symbol']: 'y'}
+        return ''.join([codes.get(e.type, 'w') for e in self.elements])
+    def flatHeader(self):
+        accessors = ''
+        for element, offset in self.layout()[0]:
+            type = flat_map.get(element.type, element.type)
+            if element.type == type_map['nodes']:
+                value = f'tree.list(id + {offset})'
+            elif element.type == type_map['string']:
+                value = f'tree.string(id + {offset})'
+            elif element.type == type_map['symbol']:
+                value = f'tree.symbol(id + {offset})'
+            else:
+                value = f'tree.words[id + {offset}]'
+            accessors += f'{type} {element.name}(void) const {{ return {value}; }}\n    '
+        return f'''class Flat{self.name} {{
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    Flat{self.name}(const FlatView& tree, NodeId id) : tree(tree), id(id) {{}}
+    {accessors.rstrip()}
+}};
+'''
+    def flatten(self):
+        offsets, words = self.layout()
+        body = ''
+        for element, offset in offsets:
+            if element.type == type_map['node']:
+                body += f'    tree.setNode(id + {offset}, {element.name});\n'
+            elif element.type == type_map['nodes']:
+                body += f'    tree.setList(id + {offset}, {element.name});\n'
+            elif element.type == type_map['string']:
+                body += f'    tree.setString(id + {offset}, {element.name});\n'
+            elif element.type == type_map['symbol']:
+                body += f'    tree.setSymbol(id + {offset}, {element.name});\n'
+            else:
+                body += f'    tree.words[id + {offset}] = {element.name};\n'
+        return f'''NodeId {self.name}::flatten(FlatTree& tree) {{
+    const NodeId id = tree.add(NodeKind::{self.name}, {words});
+{body}    return id;
+}}'''
+    def flatJSON(self):
+        json = self.json(lambda name: f'node.{name}()',
+                         lambda value: f'writeJSON(out, {value});',
+                         lambda value: f'writeList(out, {value});',
+                         '        ')
+        return f'''    case NodeKind::{self.name}: {{
+        Flat{self.name} node(*this, id);
+{json}
+        return;
+    }}'''
+
 if __name__ == '__main__':
     path = './src/ast.template'
     source = open(path, 'r').read()
@@ -97,6 +263,20 @@ if __name__ == '__main__':
         nodes.append(node)
             
     decls = '\n'.join([node.header() for node in nodes])
+    kinds = ',\n    '.join([node.name for node in nodes])
+    kind_count = len(nodes)
+    visit_cases = '\n'.join([node.visitCase() for node in nodes])
+    visit_defaults = '\n\n'.join([node.visitDefault() for node in nodes])
+    child_cases = '\n'.join([node.childCase(
+            f'auto n = static_cast<{node.name}*>(node);',
+            lambda name: f'if (n->{name}) f(n->{name});',
+            lambda name: f'for (Node* child : n->{name}) if (child) f(child);')
+            for node in nodes])
+    flat_child_cases = '\n'.join([node.childCase(
+            f'Flat{node.name} n(tree, id);',
+            lambda name: f'if (n.{name}()) f(n.{name}());',
+            lambda name: f'for (NodeId child : n.{name}()) if (child) f(child);')
+            for node in nodes])
             
     header = f'''#ifndef CAPSTONE_AST
 #define CAPSTONE_AST
@@ -104,59 +284,575 @@ if __name__ == '__main__':
 // Generated by ./scripts/ast_gen.py
 
 #include "common.h"
+#include "arena.h"
+#include "jsonwriter.h"
 #include "lexer.h"
 
+class FlatTree;
+class Node;
+
+// Index of a node record in a FlatTree, 0 is the null node.
+typedef uint32_t NodeId;
+
+enum class NodeKind : uint8_t {{
+    {kinds}
+}};
+
+const int NODE_KINDS = {kind_count};
+
+std::string getNodeKindStr(NodeKind kind);
+
+// Bytes of a node of the kind, and of the child arrays and strings a node
+// copied into the arena when it was created.
+size_t getNodeSize(NodeKind kind);
+size_t getNodeStorage(Node* node);
+
+// Nodes live in the Arena of the parse that made them and are freed with
+// it, so they can only be made through their create() factories.
 class Node {{
   public:
-    virtual std::string toJSON() = 0;
+    const NodeKind kind;
+
+    // Appends the node and its subtree to out, toJSON() collects the same
+    // into a string.
+    virtual void writeJSON(JsonWriter& out) = 0;
+    std::string toJSON(void);
+
+    static void* operator new(size_t) = delete;
+    static void* operator new[](size_t) = delete;
+
+  protected:
+    Node(NodeKind kind) : kind(kind) {{}}
 }};
 
-static std::string createList(const std::vector<Node*>&);
-static std::string safeLiterals(const std::string& str);
-static std::string nullSafeToString(Node*);
+// Child list of a node, copied into the arena when the node is created.
+class NodeList {{
+  public:
+    NodeList(Arena& arena, const std::vector<Node*>& nodes)
+        : items(arena.allocateArray<Node*>(nodes.size())), count(nodes.size()) {{
+        std::copy(nodes.begin(), nodes.end(), items);
+    }}
+
+    Node** begin(void) const {{ return items; }}
+    Node** end(void) const {{ return items + count; }}
+    size_t size(void) const {{ return count; }}
+    Node*& operator[](size_t i) const {{ return items[i]; }}
 
+  private:
+    Node** items;
+    uint32_t count;
+}};
 
 {decls}
+// Dispatch on the node kind without virtual calls. Derived visitors define
+// visitX(X*) for the kinds they handle, everything else goes to
+// visitNode(). Handlers are resolved statically so they can be inlined.
+template<typename Derived, typename Result = void>
+class Visitor {{
+  public:
+    Result visit(Node* node) {{
+        switch (node->kind) {{
+{visit_cases}
+        }}
+        return Result();
+    }}
+
+    Result visitNode(Node*) {{
+        return Result();
+    }}
+
+{visit_defaults}
+
+  private:
+    Derived& self(void) {{
+        return *static_cast<Derived*>(this);
+    }}
+}};
+
+// Call f(Node*) on every non-null child of node, in field order.
+template<typename F> void forEachChild(Node* node, F&& f) {{
+    switch (node->kind) {{
+{child_cases}
+    }}
+}}
 #endif
 '''
+
     impl = '''#include "ast.h"
 
 // Generated by ./scripts/ast_gen.py
 
-static std::string createList(const std::vector<Node*>& v) {
-    std::string result = "[";
-    for (int i = 0; i < v.size(); i++) {
-        result += nullSafeToString(v[i]);
-        if (i < v.size() - 1) result += ", ";
-    }
-    return result + "]";
-}
-
-static std::string safeLiterals(const std::string& str) {
-    std::string result = "";
-    for (char const& c : str) {
-        switch (c) {
-        case '\\n': result += "\\\\n"; break;
-        case '\\r': result += "\\\\r"; break;
-        case '\\t': result += "\\\\t"; break;
-        case '\\a': result += "\\\\a"; break;
-        case '\\b': result += "\\\\b"; break;
-        case '\\f': result += "\\\\f"; break;
-        case '\\v': result += "\\\\v"; break;
-        case '\\\\': result += "\\\\\\\\"; break;
-        case '\\'': result += "\\\\'"; break;
-        case '\\"': result += "\\\\\\""; break;
-        default: result += c;
-        }
+static void writeNode(JsonWriter& out, Node* node) {
+    if (node)
+        node->writeJSON(out);
+    else
+        out.write("null");
+}
+
+static void writeList(JsonWriter& out, const NodeList& list) {
+    out.write('[');
+    for (size_t i = 0; i < list.size(); i++) {
+        if (i) out.write(", ");
+        writeNode(out, list[i]);
+    }
+    out.write(']');
+}
+
+std::string Node::toJSON(void) {
+    JsonWriter out;
+    writeJSON(out);
+    return out.take();
+}
+
+std::string getNodeKindStr(NodeKind kind) {
+    switch (kind) {
+''' + '\n'.join([f'    case NodeKind::{node.name}: return "{node.name}";' for node in nodes]) + '''
+    }
+    return "Unknown";
+}
+
+size_t getNodeSize(NodeKind kind) {
+    switch (kind) {
+''' + '\n'.join([f'    case NodeKind::{node.name}: return sizeof({node.name});' for node in nodes]) + '''
     }
-    return result;
+    return 0;
 }
 
-static std::string nullSafeToString(Node* node) {
-    return node == nullptr ? "null" : node->toJSON();
+size_t getNodeStorage(Node* node) {
+    switch (node->kind) {
+''' + '\n'.join([node.storage() for node in nodes]) + '''
+    }
+    return 0;
 }
 
 ''' + '\n\n'.join([node.implementation() for node in nodes])
     
+    flat_decls = '\n'.join([node.flatHeader() for node in nodes])
+    layout_hash = fnv1a('\n'.join([str(node) for node in nodes]))
+
+    flat_header = f'''#ifndef CAPSTONE_FLATAST
+#define CAPSTONE_FLATAST
+
+// Generated by ./scripts/ast_gen.py
+
+#include "common.h"
+
+#include <unordered_map>
+
+#include "ast.h"
+
+// Child list of a flat node, a range of FlatView::children.
+class FlatRange {{
+  public:
+    FlatRange(const NodeId* items, uint32_t count) : items(items), count(count) {{}}
+
+    const NodeId* begin(void) const {{ return items; }}
+    const NodeId* end(void) const {{ return items + count; }}
+    size_t size(void) const {{ return count; }}
+    NodeId operator[](size_t i) const {{ return items[i]; }}
+
+  private:
+    const NodeId* items;
+    uint32_t count;
+}};
+
+// Version of the binary tree files, bumped when their header or section
+// order changes. FLAT_LAYOUT is a hash of the node declarations, so files
+// written for a different ast.template are rejected as well.
+static const uint32_t FLAT_VERSION = 1;
+static const uint32_t FLAT_LAYOUT = {layout_hash:#010x};
+
+// Read-only view of a flat tree. Every node is a record in `words`
+// starting with its kind, followed by one word per field; child lists and
+// strings take two, the start and length of their range in `children` or
+// `strings`, and symbols one, their index in `symbols`. Records are laid
+// out in preorder and addressed by the index of their first word. Word 0
+// is unused so that 0 can mean no node. There are no pointers between
+// records, so the same view reads a FlatTree in memory and a FlatFile
+// mapped from disk.
+class FlatView {{
+  public:
+    const uint32_t* words;
+    const NodeId* children;
+    const char* strings;
+    const Symbol* symbols;
+    NodeId root;
+
+    FlatView(void) : words(nullptr), children(nullptr), strings(nullptr), symbols(nullptr), root(0) {{}}
+
+    NodeKind kind(NodeId id) const {{ return (NodeKind)words[id]; }}
+    FlatRange list(NodeId at) const {{ return FlatRange(children + words[at], words[at + 1]); }}
+    std::string_view string(NodeId at) const {{ return std::string_view(strings + words[at], words[at + 1]); }}
+    Symbol symbol(NodeId at) const {{ return symbols[words[at]]; }}
+
+    void writeJSON(JsonWriter& out, NodeId id) const;
+    void writeJSON(JsonWriter& out) const {{ writeJSON(out, root); }}
+    std::string toJSON(void) const;
+
+  private:
+    void writeList(JsonWriter& out, FlatRange list) const;
+}};
+
+// Builds the flat form of a pointer tree. `symbols` holds each distinct
+// symbol of the tree once, in order of first use, and records refer to
+// them by position so that a saved tree does not depend on the ids of
+// the process that saved it.
+class FlatTree {{
+  public:
+    std::vector<uint32_t> words;
+    std::vector<NodeId> children;
+    std::vector<char> strings;
+    std::vector<Symbol> symbols;
+    NodeId root;
+
+    FlatTree(void) : words(1), root(0) {{}}
+    FlatTree(Node* node) : FlatTree() {{ root = flatten(node); }}
+
+    // valid until the tree is changed
+    FlatView view(void) const;
+    std::string toJSON(void) const {{ return view().toJSON(); }}
+
+    // write the tree to a file that FlatFile::load() maps back in
+    // returns the size of the file
+    size_t save(const std::string& path) const;
+
+    // heap bytes held by the tree, the symbol index estimated
+    size_t bytes(void) const;
+
+    // used by the generated flatten() methods of the node classes
+    NodeId flatten(Node* node);
+    NodeId add(NodeKind kind, int fields);
+    void setNode(NodeId at, Node* node);
+    void setList(NodeId at, const NodeList& list);
+    void setString(NodeId at, std::string_view text);
+    void setSymbol(NodeId at, Symbol symbol);
+
+  private:
+    std::unordered_map<Symbol, uint32_t> symbolIndex;
+}};
+
+// A tree saved by FlatTree::save(), mapped read-only and used in place.
+// Loading checks the header, the section sizes and that every record stays
+// inside its sections, and interns the names of the symbol table; the
+// records themselves are never copied or decoded.
+// Files are in the byte order of the machine that wrote them.
+class FlatFile {{
+  public:
+    ~FlatFile();
+
+    static FlatFile* load(const std::string& path);
+
+    const FlatView& view(void) const {{ return tree; }}
+    size_t bytes(void) const {{ return size; }}
+
+  private:
+    void* map;
+    size_t size;
+    std::vector<Symbol> symbols;
+    FlatView tree;
+
+    FlatFile(void) : map(nullptr), size(0) {{}}
+}};
+
+{flat_decls}
+// Call f(NodeId) on every non-null child of a flat node, in field order.
+template<typename F> void forEachChild(const FlatView& tree, NodeId id, F&& f) {{
+    switch (tree.kind(id)) {{
+{flat_child_cases}
+    }}
+}}
+#endif
+'''
+
+    flat_impl = '''#include "flatast.h"
+
+// Generated by ./scripts/ast_gen.py
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "exception.h"
+
+NodeId FlatTree::add(NodeKind kind, int fields) {
+    const NodeId id = words.size();
+    words.push_back((uint32_t)kind);
+    words.resize(words.size() + fields);
+    return id;
+}
+
+NodeId FlatTree::flatten(Node* node) {
+    if (!node) return 0;
+    switch (node->kind) {
+''' + '\n'.join([f'    case NodeKind::{node.name}: return static_cast<{node.name}*>(node)->flatten(*this);' for node in nodes]) + '''
+    }
+    return 0;
+}
+
+void FlatTree::setNode(NodeId at, Node* node) {
+    const NodeId child = flatten(node);
+    words[at] = child;
+}
+
+// The range is reserved before the children are flattened, their own
+// lists go after it.
+void FlatTree::setList(NodeId at, const NodeList& list) {
+    const uint32_t start = children.size();
+    words[at] = start;
+    words[at + 1] = list.size();
+    children.resize(start + list.size());
+    for (size_t i = 0; i < list.size(); i++) {
+        const NodeId child = flatten(list[i]);
+        children[start + i] = child;
+    }
+}
+
+void FlatTree::setString(NodeId at, std::string_view text) {
+    words[at] = strings.size();
+    words[at + 1] = text.size();
+    strings.insert(strings.end(), text.begin(), text.end());
+}
+
+void FlatTree::setSymbol(NodeId at, Symbol symbol) {
+    auto found = symbolIndex.emplace(symbol, symbols.size());
+    if (found.second) symbols.push_back(symbol);
+    words[at] = found.first->second;
+}
+
+size_t FlatTree::bytes(void) const {
+    return words.capacity() * sizeof(uint32_t) +
+           children.capacity() * sizeof(NodeId) + strings.capacity() +
+           symbols.capacity() * sizeof(Symbol) +
+           symbolIndex.size() *
+                   (sizeof(Symbol) + sizeof(uint32_t) + 2 * sizeof(void*));
+}
+
+FlatView FlatTree::view(void) const {
+    FlatView view;
+    view.words = words.data();
+    view.children = children.data();
+    view.strings = strings.data();
+    view.symbols = symbols.data();
+    view.root = root;
+    return view;
+}
+
+// A file is this header, then the words, the children and the offsets of
+// the symbol names (one more than there are symbols) as uint32 arrays,
+// then the string bytes and the symbol name bytes. Counts are in
+// elements of their section.
+struct FlatFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layout;
+    uint32_t root;
+    uint32_t words;
+    uint32_t children;
+    uint32_t symbols;
+    uint32_t strings;
+    uint32_t names;
+};
+
+static const uint32_t FLAT_MAGIC = 0x54534143; // "CAST"
+
+// What the fields of a record are, by node kind: n a child, l a child
+// list, s a string, y a symbol and w any other word. Lists and strings
+// take two words.
+static const char* const recordFields[NODE_KINDS] = {
+''' + '\n'.join([f'    "{node.fieldCodes()}", // {node.name}' for node in nodes]) + '''
+};
+
+// A file comes from disk and may be cut short or damaged, so before any
+// record is read through the view, check that the records tile `words`,
+// that every field stays inside its section, and that each record is the
+// child of at most one earlier record so that walking the tree ends.
+static bool validRecords(const FlatFileHeader& header, const uint32_t* words, const NodeId* children) {
+    enum : uint8_t { START = 1, USED = 2 };
+    std::vector<uint8_t> records(header.words, 0);
+    uint64_t id = 1;
+    while (id < header.words) {
+        if (words[id] >= NODE_KINDS) return false;
+        uint64_t size = 1;
+        for (const char* field = recordFields[words[id]]; *field; field++)
+            size += *field == 'l' || *field == 's' ? 2 : 1;
+        if (id + size > header.words) return false;
+        records[id] = START;
+        id += size;
+    }
+
+    auto child = [&](uint64_t parent, NodeId node) {
+        if (!node) return true;
+        if (node <= parent || node >= header.words || records[node] != START) return false;
+        records[node] |= USED;
+        return true;
+    };
+    for (id = 1; id < header.words;) {
+        uint64_t at = id + 1;
+        for (const char* field = recordFields[words[id]]; *field; field++) {
+            const uint32_t value = words[at];
+            switch (*field) {
+            case 'n':
+                if (!child(id, value)) return false;
+                break;
+            case 'l':
+                if ((uint64_t)value + words[at + 1] > header.children) return false;
+                for (uint32_t i = 0; i < words[at + 1]; i++)
+                    if (!child(id, children[value + i])) return false;
+                break;
+            case 's':
+                if ((uint64_t)value + words[at + 1] > header.strings) return false;
+                break;
+            case 'y':
+                if (value >= header.symbols) return false;
+                break;
+            }
+            at += *field == 'l' || *field == 's' ? 2 : 1;
+        }
+        id = at;
+    }
+    return header.root == 0 || records[header.root] == START;
+}
+
+static void writeAll(int fd, const void* data, size_t size, const std::string& path) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        const ssize_t put = write(fd, bytes, size);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            const std::string error = strerror(errno);
+            close(fd);
+            throw new Exception("Could not write " + path + ": " + error);
+        }
+        bytes += put;
+        size -= put;
+    }
+}
+
+size_t FlatTree::save(const std::string& path) const {
+    std::vector<uint32_t> offsets(1, 0);
+    std::string names;
+    for (Symbol symbol : symbols) {
+        names += SymbolTable::global().name(symbol);
+        offsets.push_back(names.size());
+    }
+
+    FlatFileHeader header;
+    header.magic = FLAT_MAGIC;
+    header.version = FLAT_VERSION;
+    header.layout = FLAT_LAYOUT;
+    header.root = root;
+    header.words = words.size();
+    header.children = children.size();
+    header.symbols = symbols.size();
+    header.strings = strings.size();
+    header.names = names.size();
+
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw new Exception("Could not open " + path + ": " + strerror(errno));
+    writeAll(fd, &header, sizeof(header), path);
+    writeAll(fd, words.data(), words.size() * sizeof(uint32_t), path);
+    writeAll(fd, children.data(), children.size() * sizeof(NodeId), path);
+    writeAll(fd, offsets.data(), offsets.size() * sizeof(uint32_t), path);
+    writeAll(fd, strings.data(), strings.size(), path);
+    writeAll(fd, names.data(), names.size(), path);
+    close(fd);
+    return sizeof(header) + words.size() * sizeof(uint32_t) +
+           children.size() * sizeof(NodeId) +
+           offsets.size() * sizeof(uint32_t) + strings.size() + names.size();
+}
+
+FlatFile::~FlatFile() {
+    if (map) munmap(map, size);
+}
+
+FlatFile* FlatFile::load(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw new Exception("Could not open " + path + ": " + strerror(errno));
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(FlatFileHeader))
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) throw new Exception("Could not map " + path);
+
+    auto file = new FlatFile();
+    file->map = map;
+    file->size = st.st_size;
+
+    const FlatFileHeader& header = *(const FlatFileHeader*)map;
+    const uint64_t expected = sizeof(FlatFileHeader) +
+            ((uint64_t)header.words + header.children + header.symbols + 1) * sizeof(uint32_t) +
+            (uint64_t)header.strings + header.names;
+    std::string error;
+    if (header.magic != FLAT_MAGIC)
+        error = "not a tree file";
+    else if (header.version != FLAT_VERSION || header.layout != FLAT_LAYOUT)
+        error = "written by a different version";
+    else if (expected != file->size || header.words == 0 || header.root >= header.words)
+        error = "truncated or corrupt";
+    if (!error.empty()) {
+        delete file;
+        throw new Exception("Could not load " + path + ": " + error);
+    }
+
+    const char* at = (const char*)map + sizeof(FlatFileHeader);
+    file->tree.words = (const uint32_t*)at;
+    at += header.words * sizeof(uint32_t);
+    file->tree.children = (const NodeId*)at;
+    at += header.children * sizeof(NodeId);
+    const uint32_t* offsets = (const uint32_t*)at;
+    at += (header.symbols + 1) * sizeof(uint32_t);
+    file->tree.strings = at;
+    const char* names = at + header.strings;
+    file->tree.root = header.root;
+    if (!validRecords(header, file->tree.words, file->tree.children)) {
+        delete file;
+        throw new Exception("Could not load " + path + ": truncated or corrupt");
+    }
+
+    file->symbols.reserve(header.symbols);
+    for (uint32_t i = 0; i < header.symbols; i++) {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > header.names) {
+            delete file;
+            throw new Exception("Could not load " + path + ": truncated or corrupt");
+        }
+        file->symbols.push_back(SymbolTable::global().intern(
+                std::string_view(names + offsets[i], offsets[i + 1] - offsets[i])));
+    }
+    file->tree.symbols = file->symbols.data();
+    return file;
+}
+
+void FlatView::writeList(JsonWriter& out, FlatRange list) const {
+    out.write('[');
+    for (size_t i = 0; i < list.size(); i++) {
+        if (i) out.write(", ");
+        writeJSON(out, list[i]);
+    }
+    out.write(']');
+}
+
+void FlatView::writeJSON(JsonWriter& out, NodeId id) const {
+    if (!id) {
+        out.write("null");
+        return;
+    }
+    switch (kind(id)) {
+''' + '\n'.join([node.flatJSON() for node in nodes]) + '''
+    }
+}
+
+std::string FlatView::toJSON(void) const {
+    JsonWriter out;
+    writeJSON(out);
+    return out.take();
+}
+
+''' + '\n\n'.join([node.flatten() for node in nodes]) + '\n'
+
     open('./src/ast.h', 'w').write(header)
-    open('./src/ast.cc', 'w').write(impl)
\ No newline at end of file
+    open('./src/ast.cc', 'w').write(impl)
+    open('./src/flatast.h', 'w').write(flat_header)
+    open('./src/flatast.cc', 'w').write(flat_impl)
\ No newline at end of file
@@ -0,0 +1,71 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "arena.h"
+
+#include "exception.h"
+
+static const size_t firstBlock = 1 << 16;
+static const size_t maxBlock = 1 << 24;
+
+Arena::Arena()
+    : blocks(nullptr), cursor(nullptr), limit(nullptr), nextSize(firstBlock),
+      used(0), reserved(0), peak(0) {
+}
+
+Arena::~Arena() {
+    release();
+}
+
+char* Arena::grow(size_t size, size_t align) {
+    // bytes of the current block that were handed out
+    if (blocks) used += cursor - ((char*)blocks + sizeof(Block));
+
+    const size_t needed = sizeof(Block) + size + align;
+    const size_t blockSize = std::max(nextSize, needed);
+    nextSize = std::min(nextSize * 2, maxBlock);
+
+    Block* block = (Block*)malloc(blockSize);
+    if (!block) throw new Exception("Out of memory");
+    block->next = blocks;
+    block->size = blockSize;
+    blocks = block;
+    reserved += blockSize;
+    peak = std::max(peak, reserved);
+
+    cursor = (char*)block + sizeof(Block);
+    limit = (char*)block + blockSize;
+    return (char*)(((uintptr_t)cursor + align - 1) & ~(align - 1));
+}
+
+std::string_view Arena::copy(std::string_view text) {
+    if (text.empty()) return std::string_view();
+    char* bytes = (char*)allocate(text.size(), 1);
+    memcpy(bytes, text.data(), text.size());
+    return std::string_view(bytes, text.size());
+}
+
+void Arena::release(void) {
+    while (blocks) {
+        Block* next = blocks->next;
+        free(blocks);
+        blocks = next;
+    }
+    cursor = limit = nullptr;
+    nextSize = firstBlock;
+    used = reserved = 0;
+}
+
+size_t Arena::bytesUsed(void) {
+    return used + (blocks ? cursor - ((char*)blocks + sizeof(Block)) : 0);
+}
+
+size_t Arena::bytesReserved(void) {
+    return reserved;
+}
+
+size_t Arena::bytesPeak(void) {
+    return peak;
+}
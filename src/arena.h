@@ -0,0 +1,58 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_ARENA
+#define CAPSTONE_ARENA
+
+#include "common.h"
+
+#include <cstddef>
+
+// Bump-pointer allocator. Objects are never freed one by one; release()
+// drops everything at once and nothing allocated here has its destructor
+// run, so only trivially destructible data (or data whose memory also
+// comes from the arena) belongs in it. Blocks double in size up to a cap,
+// so even a huge tree is a handful of blocks.
+class Arena {
+  public:
+    Arena();
+    ~Arena();
+
+    void* allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        char* p = (char*)(((uintptr_t)cursor + align - 1) & ~(align - 1));
+        if (p + size > limit) p = grow(size, align);
+        cursor = p + size;
+        return p;
+    }
+
+    template<typename T> T* allocateArray(size_t count) {
+        return (T*)allocate(count * sizeof(T), alignof(T));
+    }
+
+    std::string_view copy(std::string_view text);
+    void release(void);
+
+    size_t bytesUsed(void);
+    size_t bytesReserved(void);
+    // most bytes reserved at once since the arena was made, release()
+    // does not reset it
+    size_t bytesPeak(void);
+
+  private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    Block* blocks;
+    char* cursor;
+    char* limit;
+    size_t nextSize;
+    size_t used, reserved, peak;
+
+    char* grow(size_t size, size_t align);
+};
+
+#endif
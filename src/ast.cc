@@ -2,139 +2,480 @@
 
 // Generated by ./scripts/ast_gen.py
 
-static std::string createList(const std::vector<Node*>& v) {
-    std::string result = "[";
-    for (int i = 0; i < v.size(); i++) {
-        result += nullSafeToString(v[i]);
-        if (i < v.size() - 1) result += ", ";
+static void writeNode(JsonWriter& out, Node* node) {
+    if (node)
+        node->writeJSON(out);
+    else
+        out.write("null");
+}
+
+static void writeList(JsonWriter& out, const NodeList& list) {
+    out.write('[');
+    for (size_t i = 0; i < list.size(); i++) {
+        if (i) out.write(", ");
+        writeNode(out, list[i]);
+    }
+    out.write(']');
+}
+
+std::string Node::toJSON(void) {
+    JsonWriter out;
+    writeJSON(out);
+    return out.take();
+}
+
+std::string getNodeKindStr(NodeKind kind) {
+    switch (kind) {
+    case NodeKind::UnaryOperator: return "UnaryOperator";
+    case NodeKind::BinaryOperator: return "BinaryOperator";
+    case NodeKind::FunctionCall: return "FunctionCall";
+    case NodeKind::NumberLiteral: return "NumberLiteral";
+    case NodeKind::StringLiteral: return "StringLiteral";
+    case NodeKind::BooleanLiteral: return "BooleanLiteral";
+    case NodeKind::NullLiteral: return "NullLiteral";
+    case NodeKind::ArrayLiteral: return "ArrayLiteral";
+    case NodeKind::VariableIdentifier: return "VariableIdentifier";
+    case NodeKind::TypeIdentifier: return "TypeIdentifier";
+    case NodeKind::VariableDeclaration: return "VariableDeclaration";
+    case NodeKind::ExpressionStatement: return "ExpressionStatement";
+    case NodeKind::Block: return "Block";
+    case NodeKind::IfElseStatement: return "IfElseStatement";
+    case NodeKind::WhileStatement: return "WhileStatement";
+    case NodeKind::ForStatement: return "ForStatement";
+    case NodeKind::ParameterDeclaration: return "ParameterDeclaration";
+    case NodeKind::FunctionDeclaration: return "FunctionDeclaration";
+    case NodeKind::BreakStatement: return "BreakStatement";
+    case NodeKind::ContinueStatement: return "ContinueStatement";
+    case NodeKind::ReturnStatement: return "ReturnStatement";
+    case NodeKind::ImportStatement: return "ImportStatement";
+    case NodeKind::TernaryExpression: return "TernaryExpression";
+    case NodeKind::ClassDeclaration: return "ClassDeclaration";
+    case NodeKind::ClassField: return "ClassField";
+    case NodeKind::EnumDeclaration: return "EnumDeclaration";
+    case NodeKind::SyntaxError: return "SyntaxError";
+    }
+    return "Unknown";
+}
+
+size_t getNodeSize(NodeKind kind) {
+    switch (kind) {
+    case NodeKind::UnaryOperator: return sizeof(UnaryOperator);
+    case NodeKind::BinaryOperator: return sizeof(BinaryOperator);
+    case NodeKind::FunctionCall: return sizeof(FunctionCall);
+    case NodeKind::NumberLiteral: return sizeof(NumberLiteral);
+    case NodeKind::StringLiteral: return sizeof(StringLiteral);
+    case NodeKind::BooleanLiteral: return sizeof(BooleanLiteral);
+    case NodeKind::NullLiteral: return sizeof(NullLiteral);
+    case NodeKind::ArrayLiteral: return sizeof(ArrayLiteral);
+    case NodeKind::VariableIdentifier: return sizeof(VariableIdentifier);
+    case NodeKind::TypeIdentifier: return sizeof(TypeIdentifier);
+    case NodeKind::VariableDeclaration: return sizeof(VariableDeclaration);
+    case NodeKind::ExpressionStatement: return sizeof(ExpressionStatement);
+    case NodeKind::Block: return sizeof(Block);
+    case NodeKind::IfElseStatement: return sizeof(IfElseStatement);
+    case NodeKind::WhileStatement: return sizeof(WhileStatement);
+    case NodeKind::ForStatement: return sizeof(ForStatement);
+    case NodeKind::ParameterDeclaration: return sizeof(ParameterDeclaration);
+    case NodeKind::FunctionDeclaration: return sizeof(FunctionDeclaration);
+    case NodeKind::BreakStatement: return sizeof(BreakStatement);
+    case NodeKind::ContinueStatement: return sizeof(ContinueStatement);
+    case NodeKind::ReturnStatement: return sizeof(ReturnStatement);
+    case NodeKind::ImportStatement: return sizeof(ImportStatement);
+    case NodeKind::TernaryExpression: return sizeof(TernaryExpression);
+    case NodeKind::ClassDeclaration: return sizeof(ClassDeclaration);
+    case NodeKind::ClassField: return sizeof(ClassField);
+    case NodeKind::EnumDeclaration: return sizeof(EnumDeclaration);
+    case NodeKind::SyntaxError: return sizeof(SyntaxError);
+    }
+    return 0;
+}
+
+size_t getNodeStorage(Node* node) {
+    switch (node->kind) {
+    case NodeKind::UnaryOperator: return 0;
+    case NodeKind::BinaryOperator: return 0;
+    case NodeKind::FunctionCall: {
+        auto n = static_cast<FunctionCall*>(node);
+        return n->params.size() * sizeof(Node*);
+    }
+    case NodeKind::NumberLiteral: {
+        auto n = static_cast<NumberLiteral*>(node);
+        return n->literal.size();
+    }
+    case NodeKind::StringLiteral: {
+        auto n = static_cast<StringLiteral*>(node);
+        return n->literal.size();
+    }
+    case NodeKind::BooleanLiteral: {
+        auto n = static_cast<BooleanLiteral*>(node);
+        return n->literal.size();
+    }
+    case NodeKind::NullLiteral: return 0;
+    case NodeKind::ArrayLiteral: {
+        auto n = static_cast<ArrayLiteral*>(node);
+        return n->literal.size() * sizeof(Node*);
+    }
+    case NodeKind::VariableIdentifier: return 0;
+    case NodeKind::TypeIdentifier: {
+        auto n = static_cast<TypeIdentifier*>(node);
+        return n->children.size() * sizeof(Node*);
+    }
+    case NodeKind::VariableDeclaration: return 0;
+    case NodeKind::ExpressionStatement: return 0;
+    case NodeKind::Block: {
+        auto n = static_cast<Block*>(node);
+        return n->statements.size() * sizeof(Node*);
+    }
+    case NodeKind::IfElseStatement: return 0;
+    case NodeKind::WhileStatement: return 0;
+    case NodeKind::ForStatement: return 0;
+    case NodeKind::ParameterDeclaration: return 0;
+    case NodeKind::FunctionDeclaration: {
+        auto n = static_cast<FunctionDeclaration*>(node);
+        return n->params.size() * sizeof(Node*) + n->returns.size() * sizeof(Node*);
     }
-    return result + "]";
-}
-
-static std::string safeLiterals(const std::string& str) {
-    std::string result = "";
-    for (char const& c : str) {
-        switch (c) {
-        case '\n': result += "\\n"; break;
-        case '\r': result += "\\r"; break;
-        case '\t': result += "\\t"; break;
-        case '\a': result += "\\a"; break;
-        case '\b': result += "\\b"; break;
-        case '\f': result += "\\f"; break;
-        case '\v': result += "\\v"; break;
-        case '\\': result += "\\\\"; break;
-        case '\'': result += "\\'"; break;
-        case '\"': result += "\\\""; break;
-        default: result += c;
-        }
+    case NodeKind::BreakStatement: return 0;
+    case NodeKind::ContinueStatement: return 0;
+    case NodeKind::ReturnStatement: {
+        auto n = static_cast<ReturnStatement*>(node);
+        return n->expressions.size() * sizeof(Node*);
     }
-    return result;
+    case NodeKind::ImportStatement: return 0;
+    case NodeKind::TernaryExpression: return 0;
+    case NodeKind::ClassDeclaration: return 0;
+    case NodeKind::ClassField: return 0;
+    case NodeKind::EnumDeclaration: {
+        auto n = static_cast<EnumDeclaration*>(node);
+        return n->parts.size() * sizeof(Node*);
+    }
+    case NodeKind::SyntaxError: {
+        auto n = static_cast<SyntaxError*>(node);
+        return n->message.size();
+    }
+    }
+    return 0;
+}
+
+UnaryOperator* UnaryOperator::create(Arena& arena, Node* element, int op) {
+    return ::new (arena.allocate(sizeof(UnaryOperator), alignof(UnaryOperator))) UnaryOperator(element, op);
+}
+
+void UnaryOperator::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"UnaryOperator\",\"element\": ");
+    writeNode(out, element);
+    out.write(",\"op\": \"");
+    out.write(Lexer::getTokenStr(op));
+    out.write("\"}");
+}
+
+BinaryOperator* BinaryOperator::create(Arena& arena, Node* left, Node* right, int op) {
+    return ::new (arena.allocate(sizeof(BinaryOperator), alignof(BinaryOperator))) BinaryOperator(left, right, op);
+}
+
+void BinaryOperator::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"BinaryOperator\",\"left\": ");
+    writeNode(out, left);
+    out.write(",\"right\": ");
+    writeNode(out, right);
+    out.write(",\"op\": \"");
+    out.write(Lexer::getTokenStr(op));
+    out.write("\"}");
+}
+
+FunctionCall* FunctionCall::create(Arena& arena, Node* callback, Node* generic, const std::vector<Node*>& params) {
+    return ::new (arena.allocate(sizeof(FunctionCall), alignof(FunctionCall))) FunctionCall(callback, generic, NodeList(arena, params));
+}
+
+void FunctionCall::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"FunctionCall\",\"callback\": ");
+    writeNode(out, callback);
+    out.write(",\"generic\": ");
+    writeNode(out, generic);
+    out.write(",\"params\": ");
+    writeList(out, params);
+    out.write("}");
+}
+
+NumberLiteral* NumberLiteral::create(Arena& arena, std::string_view literal) {
+    return ::new (arena.allocate(sizeof(NumberLiteral), alignof(NumberLiteral))) NumberLiteral(arena.copy(literal));
+}
+
+void NumberLiteral::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"NumberLiteral\",\"literal\": \"");
+    out.writeEscaped(literal);
+    out.write("\"}");
+}
+
+StringLiteral* StringLiteral::create(Arena& arena, std::string_view literal) {
+    return ::new (arena.allocate(sizeof(StringLiteral), alignof(StringLiteral))) StringLiteral(arena.copy(literal));
+}
+
+void StringLiteral::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"StringLiteral\",\"literal\": \"");
+    out.writeEscaped(literal);
+    out.write("\"}");
+}
+
+BooleanLiteral* BooleanLiteral::create(Arena& arena, std::string_view literal) {
+    return ::new (arena.allocate(sizeof(BooleanLiteral), alignof(BooleanLiteral))) BooleanLiteral(arena.copy(literal));
+}
+
+void BooleanLiteral::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"BooleanLiteral\",\"literal\": \"");
+    out.writeEscaped(literal);
+    out.write("\"}");
+}
+
+NullLiteral* NullLiteral::create(Arena& arena) {
+    return ::new (arena.allocate(sizeof(NullLiteral), alignof(NullLiteral))) NullLiteral();
+}
+
+void NullLiteral::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"NullLiteral\"}");
+}
+
+ArrayLiteral* ArrayLiteral::create(Arena& arena, const std::vector<Node*>& literal) {
+    return ::new (arena.allocate(sizeof(ArrayLiteral), alignof(ArrayLiteral))) ArrayLiteral(NodeList(arena, literal));
+}
+
+void ArrayLiteral::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ArrayLiteral\",\"literal\": ");
+    writeList(out, literal);
+    out.write("}");
+}
+
+VariableIdentifier* VariableIdentifier::create(Arena& arena, Node* child, Symbol name) {
+    return ::new (arena.allocate(sizeof(VariableIdentifier), alignof(VariableIdentifier))) VariableIdentifier(child, name);
+}
+
+void VariableIdentifier::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"VariableIdentifier\",\"child\": ");
+    writeNode(out, child);
+    out.write(",\"name\": \"");
+    out.writeEscaped(SymbolTable::global().name(name));
+    out.write("\"}");
+}
+
+TypeIdentifier* TypeIdentifier::create(Arena& arena, const std::vector<Node*>& children, Symbol name, unsigned int list, unsigned int final) {
+    return ::new (arena.allocate(sizeof(TypeIdentifier), alignof(TypeIdentifier))) TypeIdentifier(NodeList(arena, children), name, list, final);
+}
+
+void TypeIdentifier::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"TypeIdentifier\",\"children\": ");
+    writeList(out, children);
+    out.write(",\"name\": \"");
+    out.writeEscaped(SymbolTable::global().name(name));
+    out.write("\",\"list\": \"");
+    out.writeNumber(list);
+    out.write("\",\"final\": \"");
+    out.writeNumber(final);
+    out.write("\"}");
+}
+
+VariableDeclaration* VariableDeclaration::create(Arena& arena, unsigned int mut, Node* type, Node* name, Node* value) {
+    return ::new (arena.allocate(sizeof(VariableDeclaration), alignof(VariableDeclaration))) VariableDeclaration(mut, type, name, value);
+}
+
+void VariableDeclaration::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"VariableDeclaration\",\"mut\": \"");
+    out.writeNumber(mut);
+    out.write("\",\"type\": ");
+    writeNode(out, type);
+    out.write(",\"name\": ");
+    writeNode(out, name);
+    out.write(",\"value\": ");
+    writeNode(out, value);
+    out.write("}");
+}
+
+ExpressionStatement* ExpressionStatement::create(Arena& arena, Node* expression) {
+    return ::new (arena.allocate(sizeof(ExpressionStatement), alignof(ExpressionStatement))) ExpressionStatement(expression);
+}
+
+void ExpressionStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ExpressionStatement\",\"expression\": ");
+    writeNode(out, expression);
+    out.write("}");
+}
+
+Block* Block::create(Arena& arena, const std::vector<Node*>& statements) {
+    return ::new (arena.allocate(sizeof(Block), alignof(Block))) Block(NodeList(arena, statements));
+}
+
+void Block::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"Block\",\"statements\": ");
+    writeList(out, statements);
+    out.write("}");
+}
+
+IfElseStatement* IfElseStatement::create(Arena& arena, Node* condition, Node* ifBlock, Node* elseBlock) {
+    return ::new (arena.allocate(sizeof(IfElseStatement), alignof(IfElseStatement))) IfElseStatement(condition, ifBlock, elseBlock);
 }
 
-static std::string nullSafeToString(Node* node) {
-    return node == nullptr ? "null" : node->toJSON();
+void IfElseStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"IfElseStatement\",\"condition\": ");
+    writeNode(out, condition);
+    out.write(",\"ifBlock\": ");
+    writeNode(out, ifBlock);
+    out.write(",\"elseBlock\": ");
+    writeNode(out, elseBlock);
+    out.write("}");
 }
 
-std::string UnaryOperator::toJSON(void) {
-    return "{\"_type\": \"UnaryOperator\",\"element\": " + nullSafeToString(element) + ",\"op\": \"" + Lexer::getTokenStr(op) + "\"}";
+WhileStatement* WhileStatement::create(Arena& arena, Node* condition, Node* block) {
+    return ::new (arena.allocate(sizeof(WhileStatement), alignof(WhileStatement))) WhileStatement(condition, block);
 }
 
-std::string BinaryOperator::toJSON(void) {
-    return "{\"_type\": \"BinaryOperator\",\"left\": " + nullSafeToString(left) + ",\"right\": " + nullSafeToString(right) + ",\"op\": \"" + Lexer::getTokenStr(op) + "\"}";
+void WhileStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"WhileStatement\",\"condition\": ");
+    writeNode(out, condition);
+    out.write(",\"block\": ");
+    writeNode(out, block);
+    out.write("}");
 }
 
-std::string FunctionCall::toJSON(void) {
-    return "{\"_type\": \"FunctionCall\",\"callback\": " + nullSafeToString(callback) + ",\"generic\": " + nullSafeToString(generic) + ",\"params\": " + createList(params) + "}";
+ForStatement* ForStatement::create(Arena& arena, Node* init, Node* condition, Node* post, Node* block) {
+    return ::new (arena.allocate(sizeof(ForStatement), alignof(ForStatement))) ForStatement(init, condition, post, block);
 }
 
-std::string NumberLiteral::toJSON(void) {
-    return "{\"_type\": \"NumberLiteral\",\"literal\": \"" + safeLiterals(literal) + "\"}";
+void ForStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ForStatement\",\"init\": ");
+    writeNode(out, init);
+    out.write(",\"condition\": ");
+    writeNode(out, condition);
+    out.write(",\"post\": ");
+    writeNode(out, post);
+    out.write(",\"block\": ");
+    writeNode(out, block);
+    out.write("}");
 }
 
-std::string StringLiteral::toJSON(void) {
-    return "{\"_type\": \"StringLiteral\",\"literal\": \"" + safeLiterals(literal) + "\"}";
+ParameterDeclaration* ParameterDeclaration::create(Arena& arena, Node* type, Node* name) {
+    return ::new (arena.allocate(sizeof(ParameterDeclaration), alignof(ParameterDeclaration))) ParameterDeclaration(type, name);
 }
 
-std::string BooleanLiteral::toJSON(void) {
-    return "{\"_type\": \"BooleanLiteral\",\"literal\": \"" + safeLiterals(literal) + "\"}";
+void ParameterDeclaration::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ParameterDeclaration\",\"type\": ");
+    writeNode(out, type);
+    out.write(",\"name\": ");
+    writeNode(out, name);
+    out.write("}");
 }
 
-std::string NullLiteral::toJSON(void) {
-    return "{\"_type\": \"NullLiteral\"}";
+FunctionDeclaration* FunctionDeclaration::create(Arena& arena, Node* name, Node* generic, const std::vector<Node*>& params, const std::vector<Node*>& returns, Node* block) {
+    return ::new (arena.allocate(sizeof(FunctionDeclaration), alignof(FunctionDeclaration))) FunctionDeclaration(name, generic, NodeList(arena, params), NodeList(arena, returns), block);
 }
 
-std::string ArrayLiteral::toJSON(void) {
-    return "{\"_type\": \"ArrayLiteral\",\"literal\": " + createList(literal) + "}";
+void FunctionDeclaration::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"FunctionDeclaration\",\"name\": ");
+    writeNode(out, name);
+    out.write(",\"generic\": ");
+    writeNode(out, generic);
+    out.write(",\"params\": ");
+    writeList(out, params);
+    out.write(",\"returns\": ");
+    writeList(out, returns);
+    out.write(",\"block\": ");
+    writeNode(out, block);
+    out.write("}");
 }
 
-std::string VariableIdentifier::toJSON(void) {
-    return "{\"_type\": \"VariableIdentifier\",\"child\": " + nullSafeToString(child) + ",\"name\": \"" + safeLiterals(name) + "\"}";
+BreakStatement* BreakStatement::create(Arena& arena) {
+    return ::new (arena.allocate(sizeof(BreakStatement), alignof(BreakStatement))) BreakStatement();
 }
 
-std::string TypeIdentifier::toJSON(void) {
-    return "{\"_type\": \"TypeIdentifier\",\"children\": " + createList(children) + ",\"name\": \"" + safeLiterals(name) + "\",\"list\": \"" + std::to_string(list) + "\",\"final\": \"" + std::to_string(final) + "\"}";
+void BreakStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"BreakStatement\"}");
 }
 
-std::string VariableDeclaration::toJSON(void) {
-    return "{\"_type\": \"VariableDeclaration\",\"mut\": \"" + std::to_string(mut) + "\",\"type\": " + nullSafeToString(type) + ",\"name\": " + nullSafeToString(name) + ",\"value\": " + nullSafeToString(value) + "}";
+ContinueStatement* ContinueStatement::create(Arena& arena) {
+    return ::new (arena.allocate(sizeof(ContinueStatement), alignof(ContinueStatement))) ContinueStatement();
 }
 
-std::string ExpressionStatement::toJSON(void) {
-    return "{\"_type\": \"ExpressionStatement\",\"expression\": " + nullSafeToString(expression) + "}";
+void ContinueStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ContinueStatement\"}");
 }
 
-std::string Block::toJSON(void) {
-    return "{\"_type\": \"Block\",\"statements\": " + createList(statements) + "}";
+ReturnStatement* ReturnStatement::create(Arena& arena, const std::vector<Node*>& expressions) {
+    return ::new (arena.allocate(sizeof(ReturnStatement), alignof(ReturnStatement))) ReturnStatement(NodeList(arena, expressions));
 }
 
-std::string IfElseStatement::toJSON(void) {
-    return "{\"_type\": \"IfElseStatement\",\"condition\": " + nullSafeToString(condition) + ",\"ifBlock\": " + nullSafeToString(ifBlock) + ",\"elseBlock\": " + nullSafeToString(elseBlock) + "}";
+void ReturnStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ReturnStatement\",\"expressions\": ");
+    writeList(out, expressions);
+    out.write("}");
 }
 
-std::string WhileStatement::toJSON(void) {
-    return "{\"_type\": \"WhileStatement\",\"condition\": " + nullSafeToString(condition) + ",\"block\": " + nullSafeToString(block) + "}";
+ImportStatement* ImportStatement::create(Arena& arena, Node* package) {
+    return ::new (arena.allocate(sizeof(ImportStatement), alignof(ImportStatement))) ImportStatement(package);
 }
 
-std::string ForStatement::toJSON(void) {
-    return "{\"_type\": \"ForStatement\",\"init\": " + nullSafeToString(init) + ",\"condition\": " + nullSafeToString(condition) + ",\"post\": " + nullSafeToString(post) + ",\"block\": " + nullSafeToString(block) + "}";
+void ImportStatement::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ImportStatement\",\"package\": ");
+    writeNode(out, package);
+    out.write("}");
 }
 
-std::string ParameterDeclaration::toJSON(void) {
-    return "{\"_type\": \"ParameterDeclaration\",\"type\": " + nullSafeToString(type) + ",\"name\": " + nullSafeToString(name) + "}";
+TernaryExpression* TernaryExpression::create(Arena& arena, Node* condition, Node* ifExpression, Node* elseExpression) {
+    return ::new (arena.allocate(sizeof(TernaryExpression), alignof(TernaryExpression))) TernaryExpression(condition, ifExpression, elseExpression);
 }
 
-std::string FunctionDeclaration::toJSON(void) {
-    return "{\"_type\": \"FunctionDeclaration\",\"name\": " + nullSafeToString(name) + ",\"generic\": " + nullSafeToString(generic) + ",\"params\": " + createList(params) + ",\"returns\": " + createList(returns) + ",\"block\": " + nullSafeToString(block) + "}";
+void TernaryExpression::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"TernaryExpression\",\"condition\": ");
+    writeNode(out, condition);
+    out.write(",\"ifExpression\": ");
+    writeNode(out, ifExpression);
+    out.write(",\"elseExpression\": ");
+    writeNode(out, elseExpression);
+    out.write("}");
 }
 
-std::string BreakStatement::toJSON(void) {
-    return "{\"_type\": \"BreakStatement\"}";
+ClassDeclaration* ClassDeclaration::create(Arena& arena, Node* name, Node* super, Node* body) {
+    return ::new (arena.allocate(sizeof(ClassDeclaration), alignof(ClassDeclaration))) ClassDeclaration(name, super, body);
 }
 
-std::string ContinueStatement::toJSON(void) {
-    return "{\"_type\": \"ContinueStatement\"}";
+void ClassDeclaration::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ClassDeclaration\",\"name\": ");
+    writeNode(out, name);
+    out.write(",\"super\": ");
+    writeNode(out, super);
+    out.write(",\"body\": ");
+    writeNode(out, body);
+    out.write("}");
 }
 
-std::string ReturnStatement::toJSON(void) {
-    return "{\"_type\": \"ReturnStatement\",\"expressions\": " + createList(expressions) + "}";
+ClassField* ClassField::create(Arena& arena, Node* member, unsigned int visibility, unsigned int staticness) {
+    return ::new (arena.allocate(sizeof(ClassField), alignof(ClassField))) ClassField(member, visibility, staticness);
 }
 
-std::string ImportStatement::toJSON(void) {
-    return "{\"_type\": \"ImportStatement\",\"package\": " + nullSafeToString(package) + "}";
+void ClassField::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"ClassField\",\"member\": ");
+    writeNode(out, member);
+    out.write(",\"visibility\": \"");
+    out.writeNumber(visibility);
+    out.write("\",\"staticness\": \"");
+    out.writeNumber(staticness);
+    out.write("\"}");
 }
 
-std::string TernaryExpression::toJSON(void) {
-    return "{\"_type\": \"TernaryExpression\",\"condition\": " + nullSafeToString(condition) + ",\"ifExpression\": " + nullSafeToString(ifExpression) + ",\"elseExpression\": " + nullSafeToString(elseExpression) + "}";
+EnumDeclaration* EnumDeclaration::create(Arena& arena, Node* name, const std::vector<Node*>& parts) {
+    return ::new (arena.allocate(sizeof(EnumDeclaration), alignof(EnumDeclaration))) EnumDeclaration(name, NodeList(arena, parts));
 }
 
-std::string ClassDeclaration::toJSON(void) {
-    return "{\"_type\": \"ClassDeclaration\",\"name\": " + nullSafeToString(name) + ",\"super\": " + nullSafeToString(super) + ",\"body\": " + nullSafeToString(body) + "}";
+void EnumDeclaration::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"EnumDeclaration\",\"name\": ");
+    writeNode(out, name);
+    out.write(",\"parts\": ");
+    writeList(out, parts);
+    out.write("}");
 }
 
-std::string ClassField::toJSON(void) {
-    return "{\"_type\": \"ClassField\",\"member\": " + nullSafeToString(member) + ",\"visibility\": \"" + std::to_string(visibility) + "\",\"staticness\": \"" + std::to_string(staticness) + "\"}";
+SyntaxError* SyntaxError::create(Arena& arena, std::string_view message) {
+    return ::new (arena.allocate(sizeof(SyntaxError), alignof(SyntaxError))) SyntaxError(arena.copy(message));
 }
 
-std::string EnumDeclaration::toJSON(void) {
-    return "{\"_type\": \"EnumDeclaration\",\"name\": " + nullSafeToString(name) + ",\"parts\": " + createList(parts) + "}";
+void SyntaxError::writeJSON(JsonWriter& out) {
+    out.write("{\"_type\": \"SyntaxError\",\"message\": \"");
+    out.writeEscaped(message);
+    out.write("\"}");
 }
\ No newline at end of file
@@ -4,25 +4,102 @@
 // Generated by ./scripts/ast_gen.py
 
 #include "common.h"
+#include "arena.h"
+#include "jsonwriter.h"
 #include "lexer.h"
 
+class FlatTree;
+class Node;
+
+// Index of a node record in a FlatTree, 0 is the null node.
+typedef uint32_t NodeId;
+
+enum class NodeKind : uint8_t {
+    UnaryOperator,
+    BinaryOperator,
+    FunctionCall,
+    NumberLiteral,
+    StringLiteral,
+    BooleanLiteral,
+    NullLiteral,
+    ArrayLiteral,
+    VariableIdentifier,
+    TypeIdentifier,
+    VariableDeclaration,
+    ExpressionStatement,
+    Block,
+    IfElseStatement,
+    WhileStatement,
+    ForStatement,
+    ParameterDeclaration,
+    FunctionDeclaration,
+    BreakStatement,
+    ContinueStatement,
+    ReturnStatement,
+    ImportStatement,
+    TernaryExpression,
+    ClassDeclaration,
+    ClassField,
+    EnumDeclaration,
+    SyntaxError
+};
+
+const int NODE_KINDS = 27;
+
+std::string getNodeKindStr(NodeKind kind);
+
+// Bytes of a node of the kind, and of the child arrays and strings a node
+// copied into the arena when it was created.
+size_t getNodeSize(NodeKind kind);
+size_t getNodeStorage(Node* node);
+
+// Nodes live in the Arena of the parse that made them and are freed with
+// it, so they can only be made through their create() factories.
 class Node {
   public:
-    virtual std::string toJSON() = 0;
-};
+    const NodeKind kind;
 
-static std::string createList(const std::vector<Node*>&);
-static std::string safeLiterals(const std::string& str);
-static std::string nullSafeToString(Node*);
+    // Appends the node and its subtree to out, toJSON() collects the same
+    // into a string.
+    virtual void writeJSON(JsonWriter& out) = 0;
+    std::string toJSON(void);
 
+    static void* operator new(size_t) = delete;
+    static void* operator new[](size_t) = delete;
+
+  protected:
+    Node(NodeKind kind) : kind(kind) {}
+};
+
+// Child list of a node, copied into the arena when the node is created.
+class NodeList {
+  public:
+    NodeList(Arena& arena, const std::vector<Node*>& nodes)
+        : items(arena.allocateArray<Node*>(nodes.size())), count(nodes.size()) {
+        std::copy(nodes.begin(), nodes.end(), items);
+    }
+
+    Node** begin(void) const { return items; }
+    Node** end(void) const { return items + count; }
+    size_t size(void) const { return count; }
+    Node*& operator[](size_t i) const { return items[i]; }
+
+  private:
+    Node** items;
+    uint32_t count;
+};
 
 class UnaryOperator : public Node {
   public:              
     Node* element;
     int op;
      
-    UnaryOperator(Node* element, int op) : element(element), op(op) {}
-    std::string toJSON(void);
+    static UnaryOperator* create(Arena& arena, Node* element, int op);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    UnaryOperator(Node* element, int op) : Node(NodeKind::UnaryOperator), element(element), op(op) {}
 };
 
 class BinaryOperator : public Node {
@@ -31,77 +108,113 @@ class BinaryOperator : public Node {
     Node* right;
     int op;
      
-    BinaryOperator(Node* left, Node* right, int op) : left(left), right(right), op(op) {}
-    std::string toJSON(void);
+    static BinaryOperator* create(Arena& arena, Node* left, Node* right, int op);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    BinaryOperator(Node* left, Node* right, int op) : Node(NodeKind::BinaryOperator), left(left), right(right), op(op) {}
 };
 
 class FunctionCall : public Node {
   public:              
     Node* callback;
     Node* generic;
-    std::vector<Node*> params;
+    NodeList params;
      
-    FunctionCall(Node* callback, Node* generic, std::vector<Node*> params) : callback(callback), generic(generic), params(params) {}
-    std::string toJSON(void);
+    static FunctionCall* create(Arena& arena, Node* callback, Node* generic, const std::vector<Node*>& params);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    FunctionCall(Node* callback, Node* generic, NodeList params) : Node(NodeKind::FunctionCall), callback(callback), generic(generic), params(params) {}
 };
 
 class NumberLiteral : public Node {
   public:              
-    std::string literal;
+    std::string_view literal;
      
-    NumberLiteral(const std::string& literal) : literal(literal) {}
-    std::string toJSON(void);
+    static NumberLiteral* create(Arena& arena, std::string_view literal);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    NumberLiteral(std::string_view literal) : Node(NodeKind::NumberLiteral), literal(literal) {}
 };
 
 class StringLiteral : public Node {
   public:              
-    std::string literal;
+    std::string_view literal;
      
-    StringLiteral(const std::string& literal) : literal(literal) {}
-    std::string toJSON(void);
+    static StringLiteral* create(Arena& arena, std::string_view literal);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    StringLiteral(std::string_view literal) : Node(NodeKind::StringLiteral), literal(literal) {}
 };
 
 class BooleanLiteral : public Node {
   public:              
-    std::string literal;
+    std::string_view literal;
      
-    BooleanLiteral(const std::string& literal) : literal(literal) {}
-    std::string toJSON(void);
+    static BooleanLiteral* create(Arena& arena, std::string_view literal);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    BooleanLiteral(std::string_view literal) : Node(NodeKind::BooleanLiteral), literal(literal) {}
 };
 
 class NullLiteral : public Node {
   public:              
      
-    NullLiteral() {}
-    std::string toJSON(void);
+    static NullLiteral* create(Arena& arena);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    NullLiteral() : Node(NodeKind::NullLiteral) {}
 };
 
 class ArrayLiteral : public Node {
   public:              
-    std::vector<Node*> literal;
+    NodeList literal;
      
-    ArrayLiteral(std::vector<Node*> literal) : literal(literal) {}
-    std::string toJSON(void);
+    static ArrayLiteral* create(Arena& arena, const std::vector<Node*>& literal);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ArrayLiteral(NodeList literal) : Node(NodeKind::ArrayLiteral), literal(literal) {}
 };
 
 class VariableIdentifier : public Node {
   public:              
     Node* child;
-    std::string name;
+    Symbol name;
      
-    VariableIdentifier(Node* child, const std::string& name) : child(child), name(name) {}
-    std::string toJSON(void);
+    static VariableIdentifier* create(Arena& arena, Node* child, Symbol name);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    VariableIdentifier(Node* child, Symbol name) : Node(NodeKind::VariableIdentifier), child(child), name(name) {}
 };
 
 class TypeIdentifier : public Node {
   public:              
-    std::vector<Node*> children;
-    std::string name;
+    NodeList children;
+    Symbol name;
     unsigned int list;
     unsigned int final;
      
-    TypeIdentifier(std::vector<Node*> children, const std::string& name, unsigned int list, unsigned int final) : children(children), name(name), list(list), final(final) {}
-    std::string toJSON(void);
+    static TypeIdentifier* create(Arena& arena, const std::vector<Node*>& children, Symbol name, unsigned int list, unsigned int final);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    TypeIdentifier(NodeList children, Symbol name, unsigned int list, unsigned int final) : Node(NodeKind::TypeIdentifier), children(children), name(name), list(list), final(final) {}
 };
 
 class VariableDeclaration : public Node {
@@ -111,24 +224,36 @@ class VariableDeclaration : public Node {
     Node* name;
     Node* value;
      
-    VariableDeclaration(unsigned int mut, Node* type, Node* name, Node* value) : mut(mut), type(type), name(name), value(value) {}
-    std::string toJSON(void);
+    static VariableDeclaration* create(Arena& arena, unsigned int mut, Node* type, Node* name, Node* value);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    VariableDeclaration(unsigned int mut, Node* type, Node* name, Node* value) : Node(NodeKind::VariableDeclaration), mut(mut), type(type), name(name), value(value) {}
 };
 
 class ExpressionStatement : public Node {
   public:              
     Node* expression;
      
-    ExpressionStatement(Node* expression) : expression(expression) {}
-    std::string toJSON(void);
+    static ExpressionStatement* create(Arena& arena, Node* expression);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ExpressionStatement(Node* expression) : Node(NodeKind::ExpressionStatement), expression(expression) {}
 };
 
 class Block : public Node {
   public:              
-    std::vector<Node*> statements;
+    NodeList statements;
      
-    Block(std::vector<Node*> statements) : statements(statements) {}
-    std::string toJSON(void);
+    static Block* create(Arena& arena, const std::vector<Node*>& statements);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    Block(NodeList statements) : Node(NodeKind::Block), statements(statements) {}
 };
 
 class IfElseStatement : public Node {
@@ -137,8 +262,12 @@ class IfElseStatement : public Node {
     Node* ifBlock;
     Node* elseBlock;
      
-    IfElseStatement(Node* condition, Node* ifBlock, Node* elseBlock) : condition(condition), ifBlock(ifBlock), elseBlock(elseBlock) {}
-    std::string toJSON(void);
+    static IfElseStatement* create(Arena& arena, Node* condition, Node* ifBlock, Node* elseBlock);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    IfElseStatement(Node* condition, Node* ifBlock, Node* elseBlock) : Node(NodeKind::IfElseStatement), condition(condition), ifBlock(ifBlock), elseBlock(elseBlock) {}
 };
 
 class WhileStatement : public Node {
@@ -146,8 +275,12 @@ class WhileStatement : public Node {
     Node* condition;
     Node* block;
      
-    WhileStatement(Node* condition, Node* block) : condition(condition), block(block) {}
-    std::string toJSON(void);
+    static WhileStatement* create(Arena& arena, Node* condition, Node* block);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    WhileStatement(Node* condition, Node* block) : Node(NodeKind::WhileStatement), condition(condition), block(block) {}
 };
 
 class ForStatement : public Node {
@@ -157,8 +290,12 @@ class ForStatement : public Node {
     Node* post;
     Node* block;
      
-    ForStatement(Node* init, Node* condition, Node* post, Node* block) : init(init), condition(condition), post(post), block(block) {}
-    std::string toJSON(void);
+    static ForStatement* create(Arena& arena, Node* init, Node* condition, Node* post, Node* block);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ForStatement(Node* init, Node* condition, Node* post, Node* block) : Node(NodeKind::ForStatement), init(init), condition(condition), post(post), block(block) {}
 };
 
 class ParameterDeclaration : public Node {
@@ -166,50 +303,74 @@ class ParameterDeclaration : public Node {
     Node* type;
     Node* name;
      
-    ParameterDeclaration(Node* type, Node* name) : type(type), name(name) {}
-    std::string toJSON(void);
+    static ParameterDeclaration* create(Arena& arena, Node* type, Node* name);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ParameterDeclaration(Node* type, Node* name) : Node(NodeKind::ParameterDeclaration), type(type), name(name) {}
 };
 
 class FunctionDeclaration : public Node {
   public:              
     Node* name;
     Node* generic;
-    std::vector<Node*> params;
-    std::vector<Node*> returns;
+    NodeList params;
+    NodeList returns;
     Node* block;
      
-    FunctionDeclaration(Node* name, Node* generic, std::vector<Node*> params, std::vector<Node*> returns, Node* block) : name(name), generic(generic), params(params), returns(returns), block(block) {}
-    std::string toJSON(void);
+    static FunctionDeclaration* create(Arena& arena, Node* name, Node* generic, const std::vector<Node*>& params, const std::vector<Node*>& returns, Node* block);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    FunctionDeclaration(Node* name, Node* generic, NodeList params, NodeList returns, Node* block) : Node(NodeKind::FunctionDeclaration), name(name), generic(generic), params(params), returns(returns), block(block) {}
 };
 
 class BreakStatement : public Node {
   public:              
      
-    BreakStatement() {}
-    std::string toJSON(void);
+    static BreakStatement* create(Arena& arena);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    BreakStatement() : Node(NodeKind::BreakStatement) {}
 };
 
 class ContinueStatement : public Node {
   public:              
      
-    ContinueStatement() {}
-    std::string toJSON(void);
+    static ContinueStatement* create(Arena& arena);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ContinueStatement() : Node(NodeKind::ContinueStatement) {}
 };
 
 class ReturnStatement : public Node {
   public:              
-    std::vector<Node*> expressions;
+    NodeList expressions;
      
-    ReturnStatement(std::vector<Node*> expressions) : expressions(expressions) {}
-    std::string toJSON(void);
+    static ReturnStatement* create(Arena& arena, const std::vector<Node*>& expressions);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ReturnStatement(NodeList expressions) : Node(NodeKind::ReturnStatement), expressions(expressions) {}
 };
 
 class ImportStatement : public Node {
   public:              
     Node* package;
      
-    ImportStatement(Node* package) : package(package) {}
-    std::string toJSON(void);
+    static ImportStatement* create(Arena& arena, Node* package);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ImportStatement(Node* package) : Node(NodeKind::ImportStatement), package(package) {}
 };
 
 class TernaryExpression : public Node {
@@ -218,8 +379,12 @@ class TernaryExpression : public Node {
     Node* ifExpression;
     Node* elseExpression;
      
-    TernaryExpression(Node* condition, Node* ifExpression, Node* elseExpression) : condition(condition), ifExpression(ifExpression), elseExpression(elseExpression) {}
-    std::string toJSON(void);
+    static TernaryExpression* create(Arena& arena, Node* condition, Node* ifExpression, Node* elseExpression);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    TernaryExpression(Node* condition, Node* ifExpression, Node* elseExpression) : Node(NodeKind::TernaryExpression), condition(condition), ifExpression(ifExpression), elseExpression(elseExpression) {}
 };
 
 class ClassDeclaration : public Node {
@@ -228,8 +393,12 @@ class ClassDeclaration : public Node {
     Node* super;
     Node* body;
      
-    ClassDeclaration(Node* name, Node* super, Node* body) : name(name), super(super), body(body) {}
-    std::string toJSON(void);
+    static ClassDeclaration* create(Arena& arena, Node* name, Node* super, Node* body);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ClassDeclaration(Node* name, Node* super, Node* body) : Node(NodeKind::ClassDeclaration), name(name), super(super), body(body) {}
 };
 
 class ClassField : public Node {
@@ -238,17 +407,354 @@ class ClassField : public Node {
     unsigned int visibility;
     unsigned int staticness;
      
-    ClassField(Node* member, unsigned int visibility, unsigned int staticness) : member(member), visibility(visibility), staticness(staticness) {}
-    std::string toJSON(void);
+    static ClassField* create(Arena& arena, Node* member, unsigned int visibility, unsigned int staticness);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    ClassField(Node* member, unsigned int visibility, unsigned int staticness) : Node(NodeKind::ClassField), member(member), visibility(visibility), staticness(staticness) {}
 };
 
 class EnumDeclaration : public Node {
   public:              
     Node* name;
-    std::vector<Node*> parts;
+    NodeList parts;
      
-    EnumDeclaration(Node* name, std::vector<Node*> parts) : name(name), parts(parts) {}
-    std::string toJSON(void);
+    static EnumDeclaration* create(Arena& arena, Node* name, const std::vector<Node*>& parts);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    EnumDeclaration(Node* name, NodeList parts) : Node(NodeKind::EnumDeclaration), name(name), parts(parts) {}
+};
+
+class SyntaxError : public Node {
+  public:              
+    std::string_view message;
+     
+    static SyntaxError* create(Arena& arena, std::string_view message);
+    void writeJSON(JsonWriter& out);
+    NodeId flatten(FlatTree& tree);
+
+  private:
+    SyntaxError(std::string_view message) : Node(NodeKind::SyntaxError), message(message) {}
+};
+
+// Dispatch on the node kind without virtual calls. Derived visitors define
+// visitX(X*) for the kinds they handle, everything else goes to
+// visitNode(). Handlers are resolved statically so they can be inlined.
+template<typename Derived, typename Result = void>
+class Visitor {
+  public:
+    Result visit(Node* node) {
+        switch (node->kind) {
+        case NodeKind::UnaryOperator:
+            return self().visitUnaryOperator(static_cast<UnaryOperator*>(node));
+        case NodeKind::BinaryOperator:
+            return self().visitBinaryOperator(static_cast<BinaryOperator*>(node));
+        case NodeKind::FunctionCall:
+            return self().visitFunctionCall(static_cast<FunctionCall*>(node));
+        case NodeKind::NumberLiteral:
+            return self().visitNumberLiteral(static_cast<NumberLiteral*>(node));
+        case NodeKind::StringLiteral:
+            return self().visitStringLiteral(static_cast<StringLiteral*>(node));
+        case NodeKind::BooleanLiteral:
+            return self().visitBooleanLiteral(static_cast<BooleanLiteral*>(node));
+        case NodeKind::NullLiteral:
+            return self().visitNullLiteral(static_cast<NullLiteral*>(node));
+        case NodeKind::ArrayLiteral:
+            return self().visitArrayLiteral(static_cast<ArrayLiteral*>(node));
+        case NodeKind::VariableIdentifier:
+            return self().visitVariableIdentifier(static_cast<VariableIdentifier*>(node));
+        case NodeKind::TypeIdentifier:
+            return self().visitTypeIdentifier(static_cast<TypeIdentifier*>(node));
+        case NodeKind::VariableDeclaration:
+            return self().visitVariableDeclaration(static_cast<VariableDeclaration*>(node));
+        case NodeKind::ExpressionStatement:
+            return self().visitExpressionStatement(static_cast<ExpressionStatement*>(node));
+        case NodeKind::Block:
+            return self().visitBlock(static_cast<Block*>(node));
+        case NodeKind::IfElseStatement:
+            return self().visitIfElseStatement(static_cast<IfElseStatement*>(node));
+        case NodeKind::WhileStatement:
+            return self().visitWhileStatement(static_cast<WhileStatement*>(node));
+        case NodeKind::ForStatement:
+            return self().visitForStatement(static_cast<ForStatement*>(node));
+        case NodeKind::ParameterDeclaration:
+            return self().visitParameterDeclaration(static_cast<ParameterDeclaration*>(node));
+        case NodeKind::FunctionDeclaration:
+            return self().visitFunctionDeclaration(static_cast<FunctionDeclaration*>(node));
+        case NodeKind::BreakStatement:
+            return self().visitBreakStatement(static_cast<BreakStatement*>(node));
+        case NodeKind::ContinueStatement:
+            return self().visitContinueStatement(static_cast<ContinueStatement*>(node));
+        case NodeKind::ReturnStatement:
+            return self().visitReturnStatement(static_cast<ReturnStatement*>(node));
+        case NodeKind::ImportStatement:
+            return self().visitImportStatement(static_cast<ImportStatement*>(node));
+        case NodeKind::TernaryExpression:
+            return self().visitTernaryExpression(static_cast<TernaryExpression*>(node));
+        case NodeKind::ClassDeclaration:
+            return self().visitClassDeclaration(static_cast<ClassDeclaration*>(node));
+        case NodeKind::ClassField:
+            return self().visitClassField(static_cast<ClassField*>(node));
+        case NodeKind::EnumDeclaration:
+            return self().visitEnumDeclaration(static_cast<EnumDeclaration*>(node));
+        case NodeKind::SyntaxError:
+            return self().visitSyntaxError(static_cast<SyntaxError*>(node));
+        }
+        return Result();
+    }
+
+    Result visitNode(Node*) {
+        return Result();
+    }
+
+    Result visitUnaryOperator(UnaryOperator* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitBinaryOperator(BinaryOperator* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitFunctionCall(FunctionCall* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitNumberLiteral(NumberLiteral* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitStringLiteral(StringLiteral* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitBooleanLiteral(BooleanLiteral* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitNullLiteral(NullLiteral* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitArrayLiteral(ArrayLiteral* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitVariableIdentifier(VariableIdentifier* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitTypeIdentifier(TypeIdentifier* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitVariableDeclaration(VariableDeclaration* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitExpressionStatement(ExpressionStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitBlock(Block* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitIfElseStatement(IfElseStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitWhileStatement(WhileStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitForStatement(ForStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitParameterDeclaration(ParameterDeclaration* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitFunctionDeclaration(FunctionDeclaration* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitBreakStatement(BreakStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitContinueStatement(ContinueStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitReturnStatement(ReturnStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitImportStatement(ImportStatement* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitTernaryExpression(TernaryExpression* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitClassDeclaration(ClassDeclaration* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitClassField(ClassField* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitEnumDeclaration(EnumDeclaration* node) {
+        return self().visitNode(node);
+    }
+
+    Result visitSyntaxError(SyntaxError* node) {
+        return self().visitNode(node);
+    }
+
+  private:
+    Derived& self(void) {
+        return *static_cast<Derived*>(this);
+    }
 };
 
+// Call f(Node*) on every non-null child of node, in field order.
+template<typename F> void forEachChild(Node* node, F&& f) {
+    switch (node->kind) {
+    case NodeKind::UnaryOperator: {
+        auto n = static_cast<UnaryOperator*>(node);
+        if (n->element) f(n->element);
+        break;
+    }
+    case NodeKind::BinaryOperator: {
+        auto n = static_cast<BinaryOperator*>(node);
+        if (n->left) f(n->left);
+        if (n->right) f(n->right);
+        break;
+    }
+    case NodeKind::FunctionCall: {
+        auto n = static_cast<FunctionCall*>(node);
+        if (n->callback) f(n->callback);
+        if (n->generic) f(n->generic);
+        for (Node* child : n->params) if (child) f(child);
+        break;
+    }
+    case NodeKind::NumberLiteral: break;
+    case NodeKind::StringLiteral: break;
+    case NodeKind::BooleanLiteral: break;
+    case NodeKind::NullLiteral: break;
+    case NodeKind::ArrayLiteral: {
+        auto n = static_cast<ArrayLiteral*>(node);
+        for (Node* child : n->literal) if (child) f(child);
+        break;
+    }
+    case NodeKind::VariableIdentifier: {
+        auto n = static_cast<VariableIdentifier*>(node);
+        if (n->child) f(n->child);
+        break;
+    }
+    case NodeKind::TypeIdentifier: {
+        auto n = static_cast<TypeIdentifier*>(node);
+        for (Node* child : n->children) if (child) f(child);
+        break;
+    }
+    case NodeKind::VariableDeclaration: {
+        auto n = static_cast<VariableDeclaration*>(node);
+        if (n->type) f(n->type);
+        if (n->name) f(n->name);
+        if (n->value) f(n->value);
+        break;
+    }
+    case NodeKind::ExpressionStatement: {
+        auto n = static_cast<ExpressionStatement*>(node);
+        if (n->expression) f(n->expression);
+        break;
+    }
+    case NodeKind::Block: {
+        auto n = static_cast<Block*>(node);
+        for (Node* child : n->statements) if (child) f(child);
+        break;
+    }
+    case NodeKind::IfElseStatement: {
+        auto n = static_cast<IfElseStatement*>(node);
+        if (n->condition) f(n->condition);
+        if (n->ifBlock) f(n->ifBlock);
+        if (n->elseBlock) f(n->elseBlock);
+        break;
+    }
+    case NodeKind::WhileStatement: {
+        auto n = static_cast<WhileStatement*>(node);
+        if (n->condition) f(n->condition);
+        if (n->block) f(n->block);
+        break;
+    }
+    case NodeKind::ForStatement: {
+        auto n = static_cast<ForStatement*>(node);
+        if (n->init) f(n->init);
+        if (n->condition) f(n->condition);
+        if (n->post) f(n->post);
+        if (n->block) f(n->block);
+        break;
+    }
+    case NodeKind::ParameterDeclaration: {
+        auto n = static_cast<ParameterDeclaration*>(node);
+        if (n->type) f(n->type);
+        if (n->name) f(n->name);
+        break;
+    }
+    case NodeKind::FunctionDeclaration: {
+        auto n = static_cast<FunctionDeclaration*>(node);
+        if (n->name) f(n->name);
+        if (n->generic) f(n->generic);
+        for (Node* child : n->params) if (child) f(child);
+        for (Node* child : n->returns) if (child) f(child);
+        if (n->block) f(n->block);
+        break;
+    }
+    case NodeKind::BreakStatement: break;
+    case NodeKind::ContinueStatement: break;
+    case NodeKind::ReturnStatement: {
+        auto n = static_cast<ReturnStatement*>(node);
+        for (Node* child : n->expressions) if (child) f(child);
+        break;
+    }
+    case NodeKind::ImportStatement: {
+        auto n = static_cast<ImportStatement*>(node);
+        if (n->package) f(n->package);
+        break;
+    }
+    case NodeKind::TernaryExpression: {
+        auto n = static_cast<TernaryExpression*>(node);
+        if (n->condition) f(n->condition);
+        if (n->ifExpression) f(n->ifExpression);
+        if (n->elseExpression) f(n->elseExpression);
+        break;
+    }
+    case NodeKind::ClassDeclaration: {
+        auto n = static_cast<ClassDeclaration*>(node);
+        if (n->name) f(n->name);
+        if (n->super) f(n->super);
+        if (n->body) f(n->body);
+        break;
+    }
+    case NodeKind::ClassField: {
+        auto n = static_cast<ClassField*>(node);
+        if (n->member) f(n->member);
+        break;
+    }
+    case NodeKind::EnumDeclaration: {
+        auto n = static_cast<EnumDeclaration*>(node);
+        if (n->name) f(n->name);
+        for (Node* child : n->parts) if (child) f(child);
+        break;
+    }
+    case NodeKind::SyntaxError: break;
+    }
+}
 #endif
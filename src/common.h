@@ -11,9 +11,11 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <assert.h>
@@ -26,6 +28,9 @@
 
 #define ASSERT(X) assert(X)
 
+// part of the parse cache key, bump it whenever parsing changes
+#define CAPSTONE_VERSION "0.2.0"
+
 #ifdef _WIN32
 #include <windows.h>
 #ifdef _DEBUG
@@ -37,10 +42,6 @@
 #include <filesystem>
 #endif
 
-#ifndef TRACE
-#define TRACE printf
-#endif
-
 #undef __STRICT_ANSI__
 
 #ifdef __GNUC__
@@ -50,6 +51,4 @@
 #define _snprintf std::snprintf
 #endif
 
-#define LOG(n) std::cout << "-> " << n << '\n'
-
 #endif
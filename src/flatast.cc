@@ -0,0 +1,768 @@
+#include "flatast.h"
+
+// Generated by ./scripts/ast_gen.py
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "exception.h"
+
+NodeId FlatTree::add(NodeKind kind, int fields) {
+    const NodeId id = words.size();
+    words.push_back((uint32_t)kind);
+    words.resize(words.size() + fields);
+    return id;
+}
+
+NodeId FlatTree::flatten(Node* node) {
+    if (!node) return 0;
+    switch (node->kind) {
+    case NodeKind::UnaryOperator: return static_cast<UnaryOperator*>(node)->flatten(*this);
+    case NodeKind::BinaryOperator: return static_cast<BinaryOperator*>(node)->flatten(*this);
+    case NodeKind::FunctionCall: return static_cast<FunctionCall*>(node)->flatten(*this);
+    case NodeKind::NumberLiteral: return static_cast<NumberLiteral*>(node)->flatten(*this);
+    case NodeKind::StringLiteral: return static_cast<StringLiteral*>(node)->flatten(*this);
+    case NodeKind::BooleanLiteral: return static_cast<BooleanLiteral*>(node)->flatten(*this);
+    case NodeKind::NullLiteral: return static_cast<NullLiteral*>(node)->flatten(*this);
+    case NodeKind::ArrayLiteral: return static_cast<ArrayLiteral*>(node)->flatten(*this);
+    case NodeKind::VariableIdentifier: return static_cast<VariableIdentifier*>(node)->flatten(*this);
+    case NodeKind::TypeIdentifier: return static_cast<TypeIdentifier*>(node)->flatten(*this);
+    case NodeKind::VariableDeclaration: return static_cast<VariableDeclaration*>(node)->flatten(*this);
+    case NodeKind::ExpressionStatement: return static_cast<ExpressionStatement*>(node)->flatten(*this);
+    case NodeKind::Block: return static_cast<Block*>(node)->flatten(*this);
+    case NodeKind::IfElseStatement: return static_cast<IfElseStatement*>(node)->flatten(*this);
+    case NodeKind::WhileStatement: return static_cast<WhileStatement*>(node)->flatten(*this);
+    case NodeKind::ForStatement: return static_cast<ForStatement*>(node)->flatten(*this);
+    case NodeKind::ParameterDeclaration: return static_cast<ParameterDeclaration*>(node)->flatten(*this);
+    case NodeKind::FunctionDeclaration: return static_cast<FunctionDeclaration*>(node)->flatten(*this);
+    case NodeKind::BreakStatement: return static_cast<BreakStatement*>(node)->flatten(*this);
+    case NodeKind::ContinueStatement: return static_cast<ContinueStatement*>(node)->flatten(*this);
+    case NodeKind::ReturnStatement: return static_cast<ReturnStatement*>(node)->flatten(*this);
+    case NodeKind::ImportStatement: return static_cast<ImportStatement*>(node)->flatten(*this);
+    case NodeKind::TernaryExpression: return static_cast<TernaryExpression*>(node)->flatten(*this);
+    case NodeKind::ClassDeclaration: return static_cast<ClassDeclaration*>(node)->flatten(*this);
+    case NodeKind::ClassField: return static_cast<ClassField*>(node)->flatten(*this);
+    case NodeKind::EnumDeclaration: return static_cast<EnumDeclaration*>(node)->flatten(*this);
+    case NodeKind::SyntaxError: return static_cast<SyntaxError*>(node)->flatten(*this);
+    }
+    return 0;
+}
+
+void FlatTree::setNode(NodeId at, Node* node) {
+    const NodeId child = flatten(node);
+    words[at] = child;
+}
+
+// The range is reserved before the children are flattened, their own
+// lists go after it.
+void FlatTree::setList(NodeId at, const NodeList& list) {
+    const uint32_t start = children.size();
+    words[at] = start;
+    words[at + 1] = list.size();
+    children.resize(start + list.size());
+    for (size_t i = 0; i < list.size(); i++) {
+        const NodeId child = flatten(list[i]);
+        children[start + i] = child;
+    }
+}
+
+void FlatTree::setString(NodeId at, std::string_view text) {
+    words[at] = strings.size();
+    words[at + 1] = text.size();
+    strings.insert(strings.end(), text.begin(), text.end());
+}
+
+void FlatTree::setSymbol(NodeId at, Symbol symbol) {
+    auto found = symbolIndex.emplace(symbol, symbols.size());
+    if (found.second) symbols.push_back(symbol);
+    words[at] = found.first->second;
+}
+
+size_t FlatTree::bytes(void) const {
+    return words.capacity() * sizeof(uint32_t) +
+           children.capacity() * sizeof(NodeId) + strings.capacity() +
+           symbols.capacity() * sizeof(Symbol) +
+           symbolIndex.size() *
+                   (sizeof(Symbol) + sizeof(uint32_t) + 2 * sizeof(void*));
+}
+
+FlatView FlatTree::view(void) const {
+    FlatView view;
+    view.words = words.data();
+    view.children = children.data();
+    view.strings = strings.data();
+    view.symbols = symbols.data();
+    view.root = root;
+    return view;
+}
+
+// A file is this header, then the words, the children and the offsets of
+// the symbol names (one more than there are symbols) as uint32 arrays,
+// then the string bytes and the symbol name bytes. Counts are in
+// elements of their section.
+struct FlatFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t layout;
+    uint32_t root;
+    uint32_t words;
+    uint32_t children;
+    uint32_t symbols;
+    uint32_t strings;
+    uint32_t names;
+};
+
+static const uint32_t FLAT_MAGIC = 0x54534143; // "CAST"
+
+// What the fields of a record are, by node kind: n a child, l a child
+// list, s a string, y a symbol and w any other word. Lists and strings
+// take two words.
+static const char* const recordFields[NODE_KINDS] = {
+    "nw", // UnaryOperator
+    "nnw", // BinaryOperator
+    "nnl", // FunctionCall
+    "s", // NumberLiteral
+    "s", // StringLiteral
+    "s", // BooleanLiteral
+    "", // NullLiteral
+    "l", // ArrayLiteral
+    "ny", // VariableIdentifier
+    "lyww", // TypeIdentifier
+    "wnnn", // VariableDeclaration
+    "n", // ExpressionStatement
+    "l", // Block
+    "nnn", // IfElseStatement
+    "nn", // WhileStatement
+    "nnnn", // ForStatement
+    "nn", // ParameterDeclaration
+    "nnlln", // FunctionDeclaration
+    "", // BreakStatement
+    "", // ContinueStatement
+    "l", // ReturnStatement
+    "n", // ImportStatement
+    "nnn", // TernaryExpression
+    "nnn", // ClassDeclaration
+    "nww", // ClassField
+    "nl", // EnumDeclaration
+    "s", // SyntaxError
+};
+
+// A file comes from disk and may be cut short or damaged, so before any
+// record is read through the view, check that the records tile `words`,
+// that every field stays inside its section, and that each record is the
+// child of at most one earlier record so that walking the tree ends.
+static bool validRecords(const FlatFileHeader& header, const uint32_t* words, const NodeId* children) {
+    enum : uint8_t { START = 1, USED = 2 };
+    std::vector<uint8_t> records(header.words, 0);
+    uint64_t id = 1;
+    while (id < header.words) {
+        if (words[id] >= NODE_KINDS) return false;
+        uint64_t size = 1;
+        for (const char* field = recordFields[words[id]]; *field; field++)
+            size += *field == 'l' || *field == 's' ? 2 : 1;
+        if (id + size > header.words) return false;
+        records[id] = START;
+        id += size;
+    }
+
+    auto child = [&](uint64_t parent, NodeId node) {
+        if (!node) return true;
+        if (node <= parent || node >= header.words || records[node] != START) return false;
+        records[node] |= USED;
+        return true;
+    };
+    for (id = 1; id < header.words;) {
+        uint64_t at = id + 1;
+        for (const char* field = recordFields[words[id]]; *field; field++) {
+            const uint32_t value = words[at];
+            switch (*field) {
+            case 'n':
+                if (!child(id, value)) return false;
+                break;
+            case 'l':
+                if ((uint64_t)value + words[at + 1] > header.children) return false;
+                for (uint32_t i = 0; i < words[at + 1]; i++)
+                    if (!child(id, children[value + i])) return false;
+                break;
+            case 's':
+                if ((uint64_t)value + words[at + 1] > header.strings) return false;
+                break;
+            case 'y':
+                if (value >= header.symbols) return false;
+                break;
+            }
+            at += *field == 'l' || *field == 's' ? 2 : 1;
+        }
+        id = at;
+    }
+    return header.root == 0 || records[header.root] == START;
+}
+
+static void writeAll(int fd, const void* data, size_t size, const std::string& path) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        const ssize_t put = write(fd, bytes, size);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            const std::string error = strerror(errno);
+            close(fd);
+            throw new Exception("Could not write " + path + ": " + error);
+        }
+        bytes += put;
+        size -= put;
+    }
+}
+
+size_t FlatTree::save(const std::string& path) const {
+    std::vector<uint32_t> offsets(1, 0);
+    std::string names;
+    for (Symbol symbol : symbols) {
+        names += SymbolTable::global().name(symbol);
+        offsets.push_back(names.size());
+    }
+
+    FlatFileHeader header;
+    header.magic = FLAT_MAGIC;
+    header.version = FLAT_VERSION;
+    header.layout = FLAT_LAYOUT;
+    header.root = root;
+    header.words = words.size();
+    header.children = children.size();
+    header.symbols = symbols.size();
+    header.strings = strings.size();
+    header.names = names.size();
+
+    const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw new Exception("Could not open " + path + ": " + strerror(errno));
+    writeAll(fd, &header, sizeof(header), path);
+    writeAll(fd, words.data(), words.size() * sizeof(uint32_t), path);
+    writeAll(fd, children.data(), children.size() * sizeof(NodeId), path);
+    writeAll(fd, offsets.data(), offsets.size() * sizeof(uint32_t), path);
+    writeAll(fd, strings.data(), strings.size(), path);
+    writeAll(fd, names.data(), names.size(), path);
+    close(fd);
+    return sizeof(header) + words.size() * sizeof(uint32_t) +
+           children.size() * sizeof(NodeId) +
+           offsets.size() * sizeof(uint32_t) + strings.size() + names.size();
+}
+
+FlatFile::~FlatFile() {
+    if (map) munmap(map, size);
+}
+
+FlatFile* FlatFile::load(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw new Exception("Could not open " + path + ": " + strerror(errno));
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(FlatFileHeader))
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) throw new Exception("Could not map " + path);
+
+    auto file = new FlatFile();
+    file->map = map;
+    file->size = st.st_size;
+
+    const FlatFileHeader& header = *(const FlatFileHeader*)map;
+    const uint64_t expected = sizeof(FlatFileHeader) +
+            ((uint64_t)header.words + header.children + header.symbols + 1) * sizeof(uint32_t) +
+            (uint64_t)header.strings + header.names;
+    std::string error;
+    if (header.magic != FLAT_MAGIC)
+        error = "not a tree file";
+    else if (header.version != FLAT_VERSION || header.layout != FLAT_LAYOUT)
+        error = "written by a different version";
+    else if (expected != file->size || header.words == 0 || header.root >= header.words)
+        error = "truncated or corrupt";
+    if (!error.empty()) {
+        delete file;
+        throw new Exception("Could not load " + path + ": " + error);
+    }
+
+    const char* at = (const char*)map + sizeof(FlatFileHeader);
+    file->tree.words = (const uint32_t*)at;
+    at += header.words * sizeof(uint32_t);
+    file->tree.children = (const NodeId*)at;
+    at += header.children * sizeof(NodeId);
+    const uint32_t* offsets = (const uint32_t*)at;
+    at += (header.symbols + 1) * sizeof(uint32_t);
+    file->tree.strings = at;
+    const char* names = at + header.strings;
+    file->tree.root = header.root;
+    if (!validRecords(header, file->tree.words, file->tree.children)) {
+        delete file;
+        throw new Exception("Could not load " + path + ": truncated or corrupt");
+    }
+
+    file->symbols.reserve(header.symbols);
+    for (uint32_t i = 0; i < header.symbols; i++) {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > header.names) {
+            delete file;
+            throw new Exception("Could not load " + path + ": truncated or corrupt");
+        }
+        file->symbols.push_back(SymbolTable::global().intern(
+                std::string_view(names + offsets[i], offsets[i + 1] - offsets[i])));
+    }
+    file->tree.symbols = file->symbols.data();
+    return file;
+}
+
+void FlatView::writeList(JsonWriter& out, FlatRange list) const {
+    out.write('[');
+    for (size_t i = 0; i < list.size(); i++) {
+        if (i) out.write(", ");
+        writeJSON(out, list[i]);
+    }
+    out.write(']');
+}
+
+void FlatView::writeJSON(JsonWriter& out, NodeId id) const {
+    if (!id) {
+        out.write("null");
+        return;
+    }
+    switch (kind(id)) {
+    case NodeKind::UnaryOperator: {
+        FlatUnaryOperator node(*this, id);
+        out.write("{\"_type\": \"UnaryOperator\",\"element\": ");
+        writeJSON(out, node.element());
+        out.write(",\"op\": \"");
+        out.write(Lexer::getTokenStr(node.op()));
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::BinaryOperator: {
+        FlatBinaryOperator node(*this, id);
+        out.write("{\"_type\": \"BinaryOperator\",\"left\": ");
+        writeJSON(out, node.left());
+        out.write(",\"right\": ");
+        writeJSON(out, node.right());
+        out.write(",\"op\": \"");
+        out.write(Lexer::getTokenStr(node.op()));
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::FunctionCall: {
+        FlatFunctionCall node(*this, id);
+        out.write("{\"_type\": \"FunctionCall\",\"callback\": ");
+        writeJSON(out, node.callback());
+        out.write(",\"generic\": ");
+        writeJSON(out, node.generic());
+        out.write(",\"params\": ");
+        writeList(out, node.params());
+        out.write("}");
+        return;
+    }
+    case NodeKind::NumberLiteral: {
+        FlatNumberLiteral node(*this, id);
+        out.write("{\"_type\": \"NumberLiteral\",\"literal\": \"");
+        out.writeEscaped(node.literal());
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::StringLiteral: {
+        FlatStringLiteral node(*this, id);
+        out.write("{\"_type\": \"StringLiteral\",\"literal\": \"");
+        out.writeEscaped(node.literal());
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::BooleanLiteral: {
+        FlatBooleanLiteral node(*this, id);
+        out.write("{\"_type\": \"BooleanLiteral\",\"literal\": \"");
+        out.writeEscaped(node.literal());
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::NullLiteral: {
+        FlatNullLiteral node(*this, id);
+        out.write("{\"_type\": \"NullLiteral\"}");
+        return;
+    }
+    case NodeKind::ArrayLiteral: {
+        FlatArrayLiteral node(*this, id);
+        out.write("{\"_type\": \"ArrayLiteral\",\"literal\": ");
+        writeList(out, node.literal());
+        out.write("}");
+        return;
+    }
+    case NodeKind::VariableIdentifier: {
+        FlatVariableIdentifier node(*this, id);
+        out.write("{\"_type\": \"VariableIdentifier\",\"child\": ");
+        writeJSON(out, node.child());
+        out.write(",\"name\": \"");
+        out.writeEscaped(SymbolTable::global().name(node.name()));
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::TypeIdentifier: {
+        FlatTypeIdentifier node(*this, id);
+        out.write("{\"_type\": \"TypeIdentifier\",\"children\": ");
+        writeList(out, node.children());
+        out.write(",\"name\": \"");
+        out.writeEscaped(SymbolTable::global().name(node.name()));
+        out.write("\",\"list\": \"");
+        out.writeNumber(node.list());
+        out.write("\",\"final\": \"");
+        out.writeNumber(node.final());
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::VariableDeclaration: {
+        FlatVariableDeclaration node(*this, id);
+        out.write("{\"_type\": \"VariableDeclaration\",\"mut\": \"");
+        out.writeNumber(node.mut());
+        out.write("\",\"type\": ");
+        writeJSON(out, node.type());
+        out.write(",\"name\": ");
+        writeJSON(out, node.name());
+        out.write(",\"value\": ");
+        writeJSON(out, node.value());
+        out.write("}");
+        return;
+    }
+    case NodeKind::ExpressionStatement: {
+        FlatExpressionStatement node(*this, id);
+        out.write("{\"_type\": \"ExpressionStatement\",\"expression\": ");
+        writeJSON(out, node.expression());
+        out.write("}");
+        return;
+    }
+    case NodeKind::Block: {
+        FlatBlock node(*this, id);
+        out.write("{\"_type\": \"Block\",\"statements\": ");
+        writeList(out, node.statements());
+        out.write("}");
+        return;
+    }
+    case NodeKind::IfElseStatement: {
+        FlatIfElseStatement node(*this, id);
+        out.write("{\"_type\": \"IfElseStatement\",\"condition\": ");
+        writeJSON(out, node.condition());
+        out.write(",\"ifBlock\": ");
+        writeJSON(out, node.ifBlock());
+        out.write(",\"elseBlock\": ");
+        writeJSON(out, node.elseBlock());
+        out.write("}");
+        return;
+    }
+    case NodeKind::WhileStatement: {
+        FlatWhileStatement node(*this, id);
+        out.write("{\"_type\": \"WhileStatement\",\"condition\": ");
+        writeJSON(out, node.condition());
+        out.write(",\"block\": ");
+        writeJSON(out, node.block());
+        out.write("}");
+        return;
+    }
+    case NodeKind::ForStatement: {
+        FlatForStatement node(*this, id);
+        out.write("{\"_type\": \"ForStatement\",\"init\": ");
+        writeJSON(out, node.init());
+        out.write(",\"condition\": ");
+        writeJSON(out, node.condition());
+        out.write(",\"post\": ");
+        writeJSON(out, node.post());
+        out.write(",\"block\": ");
+        writeJSON(out, node.block());
+        out.write("}");
+        return;
+    }
+    case NodeKind::ParameterDeclaration: {
+        FlatParameterDeclaration node(*this, id);
+        out.write("{\"_type\": \"ParameterDeclaration\",\"type\": ");
+        writeJSON(out, node.type());
+        out.write(",\"name\": ");
+        writeJSON(out, node.name());
+        out.write("}");
+        return;
+    }
+    case NodeKind::FunctionDeclaration: {
+        FlatFunctionDeclaration node(*this, id);
+        out.write("{\"_type\": \"FunctionDeclaration\",\"name\": ");
+        writeJSON(out, node.name());
+        out.write(",\"generic\": ");
+        writeJSON(out, node.generic());
+        out.write(",\"params\": ");
+        writeList(out, node.params());
+        out.write(",\"returns\": ");
+        writeList(out, node.returns());
+        out.write(",\"block\": ");
+        writeJSON(out, node.block());
+        out.write("}");
+        return;
+    }
+    case NodeKind::BreakStatement: {
+        FlatBreakStatement node(*this, id);
+        out.write("{\"_type\": \"BreakStatement\"}");
+        return;
+    }
+    case NodeKind::ContinueStatement: {
+        FlatContinueStatement node(*this, id);
+        out.write("{\"_type\": \"ContinueStatement\"}");
+        return;
+    }
+    case NodeKind::ReturnStatement: {
+        FlatReturnStatement node(*this, id);
+        out.write("{\"_type\": \"ReturnStatement\",\"expressions\": ");
+        writeList(out, node.expressions());
+        out.write("}");
+        return;
+    }
+    case NodeKind::ImportStatement: {
+        FlatImportStatement node(*this, id);
+        out.write("{\"_type\": \"ImportStatement\",\"package\": ");
+        writeJSON(out, node.package());
+        out.write("}");
+        return;
+    }
+    case NodeKind::TernaryExpression: {
+        FlatTernaryExpression node(*this, id);
+        out.write("{\"_type\": \"TernaryExpression\",\"condition\": ");
+        writeJSON(out, node.condition());
+        out.write(",\"ifExpression\": ");
+        writeJSON(out, node.ifExpression());
+        out.write(",\"elseExpression\": ");
+        writeJSON(out, node.elseExpression());
+        out.write("}");
+        return;
+    }
+    case NodeKind::ClassDeclaration: {
+        FlatClassDeclaration node(*this, id);
+        out.write("{\"_type\": \"ClassDeclaration\",\"name\": ");
+        writeJSON(out, node.name());
+        out.write(",\"super\": ");
+        writeJSON(out, node.super());
+        out.write(",\"body\": ");
+        writeJSON(out, node.body());
+        out.write("}");
+        return;
+    }
+    case NodeKind::ClassField: {
+        FlatClassField node(*this, id);
+        out.write("{\"_type\": \"ClassField\",\"member\": ");
+        writeJSON(out, node.member());
+        out.write(",\"visibility\": \"");
+        out.writeNumber(node.visibility());
+        out.write("\",\"staticness\": \"");
+        out.writeNumber(node.staticness());
+        out.write("\"}");
+        return;
+    }
+    case NodeKind::EnumDeclaration: {
+        FlatEnumDeclaration node(*this, id);
+        out.write("{\"_type\": \"EnumDeclaration\",\"name\": ");
+        writeJSON(out, node.name());
+        out.write(",\"parts\": ");
+        writeList(out, node.parts());
+        out.write("}");
+        return;
+    }
+    case NodeKind::SyntaxError: {
+        FlatSyntaxError node(*this, id);
+        out.write("{\"_type\": \"SyntaxError\",\"message\": \"");
+        out.writeEscaped(node.message());
+        out.write("\"}");
+        return;
+    }
+    }
+}
+
+std::string FlatView::toJSON(void) const {
+    JsonWriter out;
+    writeJSON(out);
+    return out.take();
+}
+
+NodeId UnaryOperator::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::UnaryOperator, 2);
+    tree.setNode(id + 1, element);
+    tree.words[id + 2] = op;
+    return id;
+}
+
+NodeId BinaryOperator::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::BinaryOperator, 3);
+    tree.setNode(id + 1, left);
+    tree.setNode(id + 2, right);
+    tree.words[id + 3] = op;
+    return id;
+}
+
+NodeId FunctionCall::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::FunctionCall, 4);
+    tree.setNode(id + 1, callback);
+    tree.setNode(id + 2, generic);
+    tree.setList(id + 3, params);
+    return id;
+}
+
+NodeId NumberLiteral::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::NumberLiteral, 2);
+    tree.setString(id + 1, literal);
+    return id;
+}
+
+NodeId StringLiteral::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::StringLiteral, 2);
+    tree.setString(id + 1, literal);
+    return id;
+}
+
+NodeId BooleanLiteral::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::BooleanLiteral, 2);
+    tree.setString(id + 1, literal);
+    return id;
+}
+
+NodeId NullLiteral::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::NullLiteral, 0);
+    return id;
+}
+
+NodeId ArrayLiteral::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ArrayLiteral, 2);
+    tree.setList(id + 1, literal);
+    return id;
+}
+
+NodeId VariableIdentifier::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::VariableIdentifier, 2);
+    tree.setNode(id + 1, child);
+    tree.setSymbol(id + 2, name);
+    return id;
+}
+
+NodeId TypeIdentifier::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::TypeIdentifier, 5);
+    tree.setList(id + 1, children);
+    tree.setSymbol(id + 3, name);
+    tree.words[id + 4] = list;
+    tree.words[id + 5] = final;
+    return id;
+}
+
+NodeId VariableDeclaration::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::VariableDeclaration, 4);
+    tree.words[id + 1] = mut;
+    tree.setNode(id + 2, type);
+    tree.setNode(id + 3, name);
+    tree.setNode(id + 4, value);
+    return id;
+}
+
+NodeId ExpressionStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ExpressionStatement, 1);
+    tree.setNode(id + 1, expression);
+    return id;
+}
+
+NodeId Block::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::Block, 2);
+    tree.setList(id + 1, statements);
+    return id;
+}
+
+NodeId IfElseStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::IfElseStatement, 3);
+    tree.setNode(id + 1, condition);
+    tree.setNode(id + 2, ifBlock);
+    tree.setNode(id + 3, elseBlock);
+    return id;
+}
+
+NodeId WhileStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::WhileStatement, 2);
+    tree.setNode(id + 1, condition);
+    tree.setNode(id + 2, block);
+    return id;
+}
+
+NodeId ForStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ForStatement, 4);
+    tree.setNode(id + 1, init);
+    tree.setNode(id + 2, condition);
+    tree.setNode(id + 3, post);
+    tree.setNode(id + 4, block);
+    return id;
+}
+
+NodeId ParameterDeclaration::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ParameterDeclaration, 2);
+    tree.setNode(id + 1, type);
+    tree.setNode(id + 2, name);
+    return id;
+}
+
+NodeId FunctionDeclaration::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::FunctionDeclaration, 7);
+    tree.setNode(id + 1, name);
+    tree.setNode(id + 2, generic);
+    tree.setList(id + 3, params);
+    tree.setList(id + 5, returns);
+    tree.setNode(id + 7, block);
+    return id;
+}
+
+NodeId BreakStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::BreakStatement, 0);
+    return id;
+}
+
+NodeId ContinueStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ContinueStatement, 0);
+    return id;
+}
+
+NodeId ReturnStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ReturnStatement, 2);
+    tree.setList(id + 1, expressions);
+    return id;
+}
+
+NodeId ImportStatement::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ImportStatement, 1);
+    tree.setNode(id + 1, package);
+    return id;
+}
+
+NodeId TernaryExpression::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::TernaryExpression, 3);
+    tree.setNode(id + 1, condition);
+    tree.setNode(id + 2, ifExpression);
+    tree.setNode(id + 3, elseExpression);
+    return id;
+}
+
+NodeId ClassDeclaration::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ClassDeclaration, 3);
+    tree.setNode(id + 1, name);
+    tree.setNode(id + 2, super);
+    tree.setNode(id + 3, body);
+    return id;
+}
+
+NodeId ClassField::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::ClassField, 3);
+    tree.setNode(id + 1, member);
+    tree.words[id + 2] = visibility;
+    tree.words[id + 3] = staticness;
+    return id;
+}
+
+NodeId EnumDeclaration::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::EnumDeclaration, 3);
+    tree.setNode(id + 1, name);
+    tree.setList(id + 2, parts);
+    return id;
+}
+
+NodeId SyntaxError::flatten(FlatTree& tree) {
+    const NodeId id = tree.add(NodeKind::SyntaxError, 2);
+    tree.setString(id + 1, message);
+    return id;
+}
@@ -0,0 +1,531 @@
+#ifndef CAPSTONE_FLATAST
+#define CAPSTONE_FLATAST
+
+// Generated by ./scripts/ast_gen.py
+
+#include "common.h"
+
+#include <unordered_map>
+
+#include "ast.h"
+
+// Child list of a flat node, a range of FlatView::children.
+class FlatRange {
+  public:
+    FlatRange(const NodeId* items, uint32_t count) : items(items), count(count) {}
+
+    const NodeId* begin(void) const { return items; }
+    const NodeId* end(void) const { return items + count; }
+    size_t size(void) const { return count; }
+    NodeId operator[](size_t i) const { return items[i]; }
+
+  private:
+    const NodeId* items;
+    uint32_t count;
+};
+
+// Version of the binary tree files, bumped when their header or section
+// order changes. FLAT_LAYOUT is a hash of the node declarations, so files
+// written for a different ast.template are rejected as well.
+static const uint32_t FLAT_VERSION = 1;
+static const uint32_t FLAT_LAYOUT = 0x8b5f1f28;
+
+// Read-only view of a flat tree. Every node is a record in `words`
+// starting with its kind, followed by one word per field; child lists and
+// strings take two, the start and length of their range in `children` or
+// `strings`, and symbols one, their index in `symbols`. Records are laid
+// out in preorder and addressed by the index of their first word. Word 0
+// is unused so that 0 can mean no node. There are no pointers between
+// records, so the same view reads a FlatTree in memory and a FlatFile
+// mapped from disk.
+class FlatView {
+  public:
+    const uint32_t* words;
+    const NodeId* children;
+    const char* strings;
+    const Symbol* symbols;
+    NodeId root;
+
+    FlatView(void) : words(nullptr), children(nullptr), strings(nullptr), symbols(nullptr), root(0) {}
+
+    NodeKind kind(NodeId id) const { return (NodeKind)words[id]; }
+    FlatRange list(NodeId at) const { return FlatRange(children + words[at], words[at + 1]); }
+    std::string_view string(NodeId at) const { return std::string_view(strings + words[at], words[at + 1]); }
+    Symbol symbol(NodeId at) const { return symbols[words[at]]; }
+
+    void writeJSON(JsonWriter& out, NodeId id) const;
+    void writeJSON(JsonWriter& out) const { writeJSON(out, root); }
+    std::string toJSON(void) const;
+
+  private:
+    void writeList(JsonWriter& out, FlatRange list) const;
+};
+
+// Builds the flat form of a pointer tree. `symbols` holds each distinct
+// symbol of the tree once, in order of first use, and records refer to
+// them by position so that a saved tree does not depend on the ids of
+// the process that saved it.
+class FlatTree {
+  public:
+    std::vector<uint32_t> words;
+    std::vector<NodeId> children;
+    std::vector<char> strings;
+    std::vector<Symbol> symbols;
+    NodeId root;
+
+    FlatTree(void) : words(1), root(0) {}
+    FlatTree(Node* node) : FlatTree() { root = flatten(node); }
+
+    // valid until the tree is changed
+    FlatView view(void) const;
+    std::string toJSON(void) const { return view().toJSON(); }
+
+    // write the tree to a file that FlatFile::load() maps back in
+    // returns the size of the file
+    size_t save(const std::string& path) const;
+
+    // heap bytes held by the tree, the symbol index estimated
+    size_t bytes(void) const;
+
+    // used by the generated flatten() methods of the node classes
+    NodeId flatten(Node* node);
+    NodeId add(NodeKind kind, int fields);
+    void setNode(NodeId at, Node* node);
+    void setList(NodeId at, const NodeList& list);
+    void setString(NodeId at, std::string_view text);
+    void setSymbol(NodeId at, Symbol symbol);
+
+  private:
+    std::unordered_map<Symbol, uint32_t> symbolIndex;
+};
+
+// A tree saved by FlatTree::save(), mapped read-only and used in place.
+// Loading checks the header, the section sizes and that every record stays
+// inside its sections, and interns the names of the symbol table; the
+// records themselves are never copied or decoded.
+// Files are in the byte order of the machine that wrote them.
+class FlatFile {
+  public:
+    ~FlatFile();
+
+    static FlatFile* load(const std::string& path);
+
+    const FlatView& view(void) const { return tree; }
+    size_t bytes(void) const { return size; }
+
+  private:
+    void* map;
+    size_t size;
+    std::vector<Symbol> symbols;
+    FlatView tree;
+
+    FlatFile(void) : map(nullptr), size(0) {}
+};
+
+class FlatUnaryOperator {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatUnaryOperator(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId element(void) const { return tree.words[id + 1]; }
+    int op(void) const { return tree.words[id + 2]; }
+};
+
+class FlatBinaryOperator {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatBinaryOperator(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId left(void) const { return tree.words[id + 1]; }
+    NodeId right(void) const { return tree.words[id + 2]; }
+    int op(void) const { return tree.words[id + 3]; }
+};
+
+class FlatFunctionCall {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatFunctionCall(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId callback(void) const { return tree.words[id + 1]; }
+    NodeId generic(void) const { return tree.words[id + 2]; }
+    FlatRange params(void) const { return tree.list(id + 3); }
+};
+
+class FlatNumberLiteral {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatNumberLiteral(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    std::string_view literal(void) const { return tree.string(id + 1); }
+};
+
+class FlatStringLiteral {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatStringLiteral(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    std::string_view literal(void) const { return tree.string(id + 1); }
+};
+
+class FlatBooleanLiteral {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatBooleanLiteral(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    std::string_view literal(void) const { return tree.string(id + 1); }
+};
+
+class FlatNullLiteral {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatNullLiteral(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    
+};
+
+class FlatArrayLiteral {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatArrayLiteral(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    FlatRange literal(void) const { return tree.list(id + 1); }
+};
+
+class FlatVariableIdentifier {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatVariableIdentifier(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId child(void) const { return tree.words[id + 1]; }
+    Symbol name(void) const { return tree.symbol(id + 2); }
+};
+
+class FlatTypeIdentifier {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatTypeIdentifier(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    FlatRange children(void) const { return tree.list(id + 1); }
+    Symbol name(void) const { return tree.symbol(id + 3); }
+    unsigned int list(void) const { return tree.words[id + 4]; }
+    unsigned int final(void) const { return tree.words[id + 5]; }
+};
+
+class FlatVariableDeclaration {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatVariableDeclaration(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    unsigned int mut(void) const { return tree.words[id + 1]; }
+    NodeId type(void) const { return tree.words[id + 2]; }
+    NodeId name(void) const { return tree.words[id + 3]; }
+    NodeId value(void) const { return tree.words[id + 4]; }
+};
+
+class FlatExpressionStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatExpressionStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId expression(void) const { return tree.words[id + 1]; }
+};
+
+class FlatBlock {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatBlock(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    FlatRange statements(void) const { return tree.list(id + 1); }
+};
+
+class FlatIfElseStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatIfElseStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId condition(void) const { return tree.words[id + 1]; }
+    NodeId ifBlock(void) const { return tree.words[id + 2]; }
+    NodeId elseBlock(void) const { return tree.words[id + 3]; }
+};
+
+class FlatWhileStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatWhileStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId condition(void) const { return tree.words[id + 1]; }
+    NodeId block(void) const { return tree.words[id + 2]; }
+};
+
+class FlatForStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatForStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId init(void) const { return tree.words[id + 1]; }
+    NodeId condition(void) const { return tree.words[id + 2]; }
+    NodeId post(void) const { return tree.words[id + 3]; }
+    NodeId block(void) const { return tree.words[id + 4]; }
+};
+
+class FlatParameterDeclaration {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatParameterDeclaration(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId type(void) const { return tree.words[id + 1]; }
+    NodeId name(void) const { return tree.words[id + 2]; }
+};
+
+class FlatFunctionDeclaration {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatFunctionDeclaration(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId name(void) const { return tree.words[id + 1]; }
+    NodeId generic(void) const { return tree.words[id + 2]; }
+    FlatRange params(void) const { return tree.list(id + 3); }
+    FlatRange returns(void) const { return tree.list(id + 5); }
+    NodeId block(void) const { return tree.words[id + 7]; }
+};
+
+class FlatBreakStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatBreakStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    
+};
+
+class FlatContinueStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatContinueStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    
+};
+
+class FlatReturnStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatReturnStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    FlatRange expressions(void) const { return tree.list(id + 1); }
+};
+
+class FlatImportStatement {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatImportStatement(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId package(void) const { return tree.words[id + 1]; }
+};
+
+class FlatTernaryExpression {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatTernaryExpression(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId condition(void) const { return tree.words[id + 1]; }
+    NodeId ifExpression(void) const { return tree.words[id + 2]; }
+    NodeId elseExpression(void) const { return tree.words[id + 3]; }
+};
+
+class FlatClassDeclaration {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatClassDeclaration(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId name(void) const { return tree.words[id + 1]; }
+    NodeId super(void) const { return tree.words[id + 2]; }
+    NodeId body(void) const { return tree.words[id + 3]; }
+};
+
+class FlatClassField {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatClassField(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId member(void) const { return tree.words[id + 1]; }
+    unsigned int visibility(void) const { return tree.words[id + 2]; }
+    unsigned int staticness(void) const { return tree.words[id + 3]; }
+};
+
+class FlatEnumDeclaration {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatEnumDeclaration(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    NodeId name(void) const { return tree.words[id + 1]; }
+    FlatRange parts(void) const { return tree.list(id + 2); }
+};
+
+class FlatSyntaxError {
+  public:
+    const FlatView& tree;
+    const NodeId id;
+
+    FlatSyntaxError(const FlatView& tree, NodeId id) : tree(tree), id(id) {}
+    std::string_view message(void) const { return tree.string(id + 1); }
+};
+
+// Call f(NodeId) on every non-null child of a flat node, in field order.
+template<typename F> void forEachChild(const FlatView& tree, NodeId id, F&& f) {
+    switch (tree.kind(id)) {
+    case NodeKind::UnaryOperator: {
+        FlatUnaryOperator n(tree, id);
+        if (n.element()) f(n.element());
+        break;
+    }
+    case NodeKind::BinaryOperator: {
+        FlatBinaryOperator n(tree, id);
+        if (n.left()) f(n.left());
+        if (n.right()) f(n.right());
+        break;
+    }
+    case NodeKind::FunctionCall: {
+        FlatFunctionCall n(tree, id);
+        if (n.callback()) f(n.callback());
+        if (n.generic()) f(n.generic());
+        for (NodeId child : n.params()) if (child) f(child);
+        break;
+    }
+    case NodeKind::NumberLiteral: break;
+    case NodeKind::StringLiteral: break;
+    case NodeKind::BooleanLiteral: break;
+    case NodeKind::NullLiteral: break;
+    case NodeKind::ArrayLiteral: {
+        FlatArrayLiteral n(tree, id);
+        for (NodeId child : n.literal()) if (child) f(child);
+        break;
+    }
+    case NodeKind::VariableIdentifier: {
+        FlatVariableIdentifier n(tree, id);
+        if (n.child()) f(n.child());
+        break;
+    }
+    case NodeKind::TypeIdentifier: {
+        FlatTypeIdentifier n(tree, id);
+        for (NodeId child : n.children()) if (child) f(child);
+        break;
+    }
+    case NodeKind::VariableDeclaration: {
+        FlatVariableDeclaration n(tree, id);
+        if (n.type()) f(n.type());
+        if (n.name()) f(n.name());
+        if (n.value()) f(n.value());
+        break;
+    }
+    case NodeKind::ExpressionStatement: {
+        FlatExpressionStatement n(tree, id);
+        if (n.expression()) f(n.expression());
+        break;
+    }
+    case NodeKind::Block: {
+        FlatBlock n(tree, id);
+        for (NodeId child : n.statements()) if (child) f(child);
+        break;
+    }
+    case NodeKind::IfElseStatement: {
+        FlatIfElseStatement n(tree, id);
+        if (n.condition()) f(n.condition());
+        if (n.ifBlock()) f(n.ifBlock());
+        if (n.elseBlock()) f(n.elseBlock());
+        break;
+    }
+    case NodeKind::WhileStatement: {
+        FlatWhileStatement n(tree, id);
+        if (n.condition()) f(n.condition());
+        if (n.block()) f(n.block());
+        break;
+    }
+    case NodeKind::ForStatement: {
+        FlatForStatement n(tree, id);
+        if (n.init()) f(n.init());
+        if (n.condition()) f(n.condition());
+        if (n.post()) f(n.post());
+        if (n.block()) f(n.block());
+        break;
+    }
+    case NodeKind::ParameterDeclaration: {
+        FlatParameterDeclaration n(tree, id);
+        if (n.type()) f(n.type());
+        if (n.name()) f(n.name());
+        break;
+    }
+    case NodeKind::FunctionDeclaration: {
+        FlatFunctionDeclaration n(tree, id);
+        if (n.name()) f(n.name());
+        if (n.generic()) f(n.generic());
+        for (NodeId child : n.params()) if (child) f(child);
+        for (NodeId child : n.returns()) if (child) f(child);
+        if (n.block()) f(n.block());
+        break;
+    }
+    case NodeKind::BreakStatement: break;
+    case NodeKind::ContinueStatement: break;
+    case NodeKind::ReturnStatement: {
+        FlatReturnStatement n(tree, id);
+        for (NodeId child : n.expressions()) if (child) f(child);
+        break;
+    }
+    case NodeKind::ImportStatement: {
+        FlatImportStatement n(tree, id);
+        if (n.package()) f(n.package());
+        break;
+    }
+    case NodeKind::TernaryExpression: {
+        FlatTernaryExpression n(tree, id);
+        if (n.condition()) f(n.condition());
+        if (n.ifExpression()) f(n.ifExpression());
+        if (n.elseExpression()) f(n.elseExpression());
+        break;
+    }
+    case NodeKind::ClassDeclaration: {
+        FlatClassDeclaration n(tree, id);
+        if (n.name()) f(n.name());
+        if (n.super()) f(n.super());
+        if (n.body()) f(n.body());
+        break;
+    }
+    case NodeKind::ClassField: {
+        FlatClassField n(tree, id);
+        if (n.member()) f(n.member());
+        break;
+    }
+    case NodeKind::EnumDeclaration: {
+        FlatEnumDeclaration n(tree, id);
+        if (n.name()) f(n.name());
+        for (NodeId child : n.parts()) if (child) f(child);
+        break;
+    }
+    case NodeKind::SyntaxError: break;
+    }
+}
+#endif
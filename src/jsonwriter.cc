@@ -0,0 +1,90 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "jsonwriter.h"
+
+#include "exception.h"
+
+JsonWriter::JsonWriter() : fd(-1), flushed(0) {
+}
+
+JsonWriter::JsonWriter(int fd) : fd(fd), flushed(0) {
+    buffer.reserve(flushSize + (flushSize >> 4));
+}
+
+JsonWriter::~JsonWriter() {
+    if (fd < 0) return;
+    try {
+        flush();
+    } catch (Exception* e) { delete e; }
+}
+
+void JsonWriter::writeEscaped(std::string_view text) {
+    // copy runs of plain bytes in one go
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        const char* escape;
+        switch (text[i]) {
+        case '\n': escape = "\\n"; break;
+        case '\r': escape = "\\r"; break;
+        case '\t': escape = "\\t"; break;
+        case '\a': escape = "\\a"; break;
+        case '\b': escape = "\\b"; break;
+        case '\f': escape = "\\f"; break;
+        case '\v': escape = "\\v"; break;
+        case '\\': escape = "\\\\"; break;
+        case '\'': escape = "\\'"; break;
+        case '\"': escape = "\\\""; break;
+        default: continue;
+        }
+        buffer.append(text.data() + run, i - run);
+        buffer.append(escape, 2);
+        run = i + 1;
+    }
+    write(text.substr(run));
+}
+
+void JsonWriter::writeNumber(unsigned int n) {
+    char digits[16];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+    do {
+        *--p = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    buffer.append(p, end - p);
+}
+
+void JsonWriter::flush(void) {
+    if (fd < 0) return;
+    size_t done = 0;
+    while (done < buffer.size()) {
+        const ssize_t put =
+                ::write(fd, buffer.data() + done, buffer.size() - done);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            buffer.clear();
+            throw new Exception(std::string("Could not write JSON: ") +
+                                strerror(errno));
+        }
+        done += put;
+    }
+    flushed += done;
+    buffer.clear();
+}
+
+std::string_view JsonWriter::view(void) const {
+    return buffer;
+}
+
+std::string JsonWriter::take(void) {
+    std::string result;
+    result.swap(buffer);
+    return result;
+}
+
+size_t JsonWriter::bytesWritten(void) const {
+    return flushed + buffer.size();
+}
@@ -0,0 +1,46 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_JSONWRITER
+#define CAPSTONE_JSONWRITER
+
+#include "common.h"
+
+// Append-only output for the generated writeJSON() methods. Everything
+// goes into one growable buffer; a writer made with a file descriptor
+// hands the buffer to write(2) whenever it passes flushSize, so a tree
+// of any size is serialized in a bounded amount of memory.
+class JsonWriter {
+  public:
+    static const size_t flushSize = 1 << 20;
+
+    JsonWriter();
+    JsonWriter(int fd);
+    ~JsonWriter();
+
+    void write(char c) {
+        buffer.push_back(c);
+    }
+    void write(std::string_view text) {
+        buffer.append(text.data(), text.size());
+        if (fd >= 0 && buffer.size() >= flushSize) flush();
+    }
+    void writeEscaped(std::string_view text);
+    void writeNumber(unsigned int n);
+
+    void flush(void);
+
+    // everything written so far, only for writers without a descriptor
+    std::string_view view(void) const;
+    std::string take(void);
+    size_t bytesWritten(void) const;
+
+  private:
+    std::string buffer;
+    int fd;
+    size_t flushed;
+};
+
+#endif
@@ -5,33 +5,43 @@
  */
 #include "lexer.h"
 
-Lexer::Lexer(const std::string& input) {
-    data = _strdup(input.c_str());
-    dataOwned = true;
+Lexer::Lexer(const std::string& input) : Lexer(new SourceBuffer(input)) {
+    sourceOwned = true;
+}
+
+Lexer::Lexer(SourceBuffer* source) {
+    this->source = source;
+    sourceOwned = false;
+    symbols = &SymbolTable::global();
+    data = source->data;
     dataStart = 0;
-    dataEnd = strlen(data);
+    dataEnd = source->size;
     reset();
 }
 
 Lexer::Lexer(Lexer* owner, int startChar, int endChar) {
+    source = owner->source;
+    sourceOwned = false;
+    symbols = owner->symbols;
     data = owner->data;
-    dataOwned = false;
     dataStart = startChar;
     dataEnd = endChar;
     reset();
 }
 
 Lexer::~Lexer(void) {
-    if (dataOwned) free((void*)data);
+    if (sourceOwned) delete source;
 }
 
 void Lexer::reset() {
     dataPos = dataStart;
+    std::fill(symbolCache, symbolCache + 256, 0);
     tokenStart = 0;
     tokenEnd = 0;
     tokenLastEnd = 0;
     tk = 0;
-    tkStr = "";
+    tkStr = std::string_view();
+    tkSymbol = 0;
     getNextCh();
     getNextCh();
     getNextToken();
@@ -122,316 +132,321 @@ void Lexer::getNextCh() {
     dataPos++;
 }
 
-void Lexer::getNextToken() {
-    tk = TOK_EOF;
-    tkStr.clear();
-    while (currCh && isWhitespace(currCh)) getNextCh();
+// Character classes for the scanner, one table lookup per byte instead of
+// the isAlpha/isNumeric/isWhitespace chains in utils.cc.
+enum CHAR_CLASSES {
+    CH_SPACE = 1 << 0,
+    CH_ALPHA = 1 << 1,
+    CH_DIGIT = 1 << 2,
+    CH_HEX = 1 << 3,
+};
+
+#define S CH_SPACE
+#define A CH_ALPHA
+#define D (CH_DIGIT | CH_HEX)
+#define H (CH_ALPHA | CH_HEX)
+static const unsigned char charClass[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, S, 0, 0, S, 0, 0, // 0x00
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x10
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 0x20
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0, // 0x30
+    0, H, H, H, H, H, H, A, A, A, A, A, A, A, A, A, // 0x40
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, A, // 0x50
+    0, H, H, H, H, H, H, A, A, A, A, A, A, A, A, A, // 0x60
+    A, A, A, A, A, A, A, A, A, A, A, 0, 0, 0, 0, 0, // 0x70
+};
+#undef S
+#undef A
+#undef D
+#undef H
+
+static inline bool isClass(char ch, unsigned char mask) {
+    return charClass[(unsigned char)ch] & mask;
+}
 
-    if (currCh == '/' && nextCh == '/') {
-        while (currCh && currCh != '\n') getNextCh();
-        getNextCh();
-        getNextToken();
-        return;
+// Multi-character operators as transitions from the token matched so far.
+// Single characters are their own token, so every operator starts in the
+// state of its first character.
+struct OpTransition {
+    int from;
+    char ch;
+    int to;
+};
+
+static const OpTransition opTransitions[] = {
+    {'=', '=', TOK_EQUAL},          {'!', '=', TOK_NEQUAL},
+    {'<', '=', TOK_LEQUAL},         {'<', '<', TOK_LSHIFT},
+    {'<', '-', TOK_LSINGLEARROW},   {TOK_LSHIFT, '=', TOK_LSHIFTEQUAL},
+    {TOK_LEQUAL, '>', TOK_SPACESHIP}, {'>', '=', TOK_GEQUAL},
+    {'>', '>', TOK_RSHIFT},         {TOK_RSHIFT, '=', TOK_RSHIFTEQUAL},
+    {'+', '=', TOK_PLUSEQUAL},      {'+', '+', TOK_PLUSPLUS},
+    {'-', '=', TOK_MINUSEQUAL},     {'-', '-', TOK_MINUSMINUS},
+    {'-', '>', TOK_RSINGLEARROW},   {'*', '=', TOK_TIMESEQUAL},
+    {'/', '=', TOK_DIVIDEEQUAL},    {'%', '=', TOK_MODEQUAL},
+    {'&', '=', TOK_ANDEQUAL},       {'&', '&', TOK_ANDAND},
+    {'|', '=', TOK_OREQUAL},        {'|', '|', TOK_OROR},
+    {'^', '=', TOK_XOREQUAL},       {':', ':', TOK_COLONCOLON},
+    {':', '<', TOK_GENERIC},
+};
+
+// Dense form of opTransitions: opState maps a token to a row of opTable,
+// and opTable[row][ch] is the token after consuming ch (0 when the operator
+// ends). Row 0 is the dead state.
+static const int OP_STATES = 32;
+static unsigned char opState[TOK_R_LIST_END];
+static int opTable[OP_STATES][128];
+
+static struct OpTableInit {
+    OpTableInit() {
+        int rows = 1;
+        for (const OpTransition& t : opTransitions) {
+            if (!opState[t.from]) opState[t.from] = rows++;
+            opTable[opState[t.from]][(unsigned char)t.ch] = t.to;
+        }
+        ASSERT(rows <= OP_STATES);
     }
-
-    if (currCh == '/' && nextCh == '*') {
-        while (currCh && (currCh != '*' || nextCh != '/')) getNextCh();
-        getNextCh();
-        getNextCh();
-        getNextToken();
-        return;
+} opTableInit;
+
+// Reserved words, switched on length and first character so an identifier
+// costs at most one memcmp against a candidate.
+static int lookupReservedWord(const char* s, int len) {
+#define RESERVED(word, token)                                                  \
+    if (memcmp(s, word, len) == 0) return token;                               \
+    break
+    switch (len) {
+    case 2:
+        if (s[0] == 'i' && s[1] == 'f') return TOK_R_IF;
+        break;
+    case 3:
+        switch (s[0]) {
+        case 'f': RESERVED("for", TOK_R_FOR);
+        case 'n': RESERVED("nil", TOK_R_NULL);
+        case 'v': RESERVED("var", TOK_R_VAR);
+        case 'l': RESERVED("let", TOK_R_VAR);
+        }
+        break;
+    case 4:
+        switch (s[0]) {
+        case 'e':
+            if (memcmp(s, "else", 4) == 0) return TOK_R_ELSE;
+            RESERVED("enum", TOK_R_ENUM);
+        case 'f': RESERVED("func", TOK_R_FUNC);
+        case 't': RESERVED("true", TOK_R_TRUE);
+        case 'n': RESERVED("null", TOK_R_NULL);
+        }
+        break;
+    case 5:
+        switch (s[0]) {
+        case 'w': RESERVED("while", TOK_R_WHILE);
+        case 'b': RESERVED("break", TOK_R_BREAK);
+        case 'c':
+            if (memcmp(s, "class", 5) == 0) return TOK_R_CLASS;
+            RESERVED("const", TOK_R_CONST);
+        case 'f':
+            if (memcmp(s, "false", 5) == 0) return TOK_R_FALSE;
+            RESERVED("final", TOK_R_CONST);
+        }
+        break;
+    case 6:
+        switch (s[0]) {
+        case 'r': RESERVED("return", TOK_R_RETURN);
+        case 'p': RESERVED("public", TOK_R_PUBLIC);
+        case 's': RESERVED("static", TOK_R_STATIC);
+        case 'i': RESERVED("import", TOK_R_IMPORT);
+        }
+        break;
+    case 7:
+        if (s[0] == 'p' && memcmp(s, "private", 7) == 0) return TOK_R_PRIVATE;
+        break;
+    case 8:
+        if (s[0] == 'c' && memcmp(s, "continue", 8) == 0)
+            return TOK_R_CONTINUE;
+        break;
+    case 9:
+        if (s[0] == 'p' && memcmp(s, "protected", 9) == 0)
+            return TOK_R_PROTECTED;
+        break;
     }
+#undef RESERVED
+    return TOK_ID;
+}
 
-    tokenStart = dataPos - 2;
+char Lexer::charAt(int pos) {
+    return pos < dataEnd ? data[pos] : 0;
+}
 
-    if (isAlpha(currCh)) {
-        while (isAlpha(currCh) || isNumeric(currCh)) {
-            tkStr += currCh;
-            getNextCh();
-        }
+void Lexer::seek(int pos) {
+    dataPos = pos;
+    getNextCh();
+    getNextCh();
+}
 
-        tk = TOK_ID;
-
-        if (tkStr == "if")
-            tk = TOK_R_IF;
-        else if (tkStr == "else")
-            tk = TOK_R_ELSE;
-        else if (tkStr == "while")
-            tk = TOK_R_WHILE;
-        else if (tkStr == "for")
-            tk = TOK_R_FOR;
-        else if (tkStr == "break")
-            tk = TOK_R_BREAK;
-        else if (tkStr == "continue")
-            tk = TOK_R_CONTINUE;
-        else if (tkStr == "func")
-            tk = TOK_R_FUNC;
-        else if (tkStr == "return")
-            tk = TOK_R_RETURN;
-        else if (tkStr == "enum")
-            tk = TOK_R_ENUM;
-        else if (tkStr == "class")
-            tk = TOK_R_CLASS;
-        else if (tkStr == "public")
-            tk = TOK_R_PUBLIC;
-        else if (tkStr == "protected")
-            tk = TOK_R_PROTECTED;
-        else if (tkStr == "private")
-            tk = TOK_R_PRIVATE;
-        else if (tkStr == "static")
-            tk = TOK_R_STATIC;
-        else if (tkStr == "true")
-            tk = TOK_R_TRUE;
-        else if (tkStr == "false")
-            tk = TOK_R_FALSE;
-        else if (tkStr == "null")
-            tk = TOK_R_NULL;
-        else if (tkStr == "nil")
-            tk = TOK_R_NULL;
-        else if (tkStr == "const")
-            tk = TOK_R_CONST;
-        else if (tkStr == "final")
-            tk = TOK_R_CONST;
-        else if (tkStr == "import")
-            tk = TOK_R_IMPORT;
-        else if (tkStr == "var")
-            tk = TOK_R_VAR;
-        else if (tkStr == "let")
-            tk = TOK_R_VAR;
-
-    } else if (isNumeric(currCh)) {
-        bool isHex = false;
-        if (currCh == '0') {
-            tkStr += currCh;
-            getNextCh();
+void Lexer::getNextToken() {
+    tk = TOK_EOF;
+    tkStr = std::string_view();
+    tkSymbol = 0;
+
+    // The scanner works on an index into data and resyncs currCh/nextCh
+    // once the token is done.
+    int p = dataPos - 2;
+    for (;;) {
+        // single separators are the common case, only runs go to the kernel
+        if (p < dataEnd && isClass(data[p], CH_SPACE) &&
+            ++p < dataEnd && isClass(data[p], CH_SPACE))
+            p = scanWhitespace(data, p + 1, dataEnd);
+        if (charAt(p) != '/') break;
+        if (charAt(p + 1) == '/') {
+            p = scanUntil(data, p + 2, dataEnd, '\n', 0, 0) + 1;
+        } else if (charAt(p + 1) == '*') {
+            // look for the '/' of "*/", stars are common in banners
+            const int body = p + 2;
+            p = body;
+            while ((p = scanUntil(data, p, dataEnd, '/', 0, 0)) < dataEnd &&
+                   data[p] && (p == body || data[p - 1] != '*'))
+                p++;
+            p += charAt(p) ? 1 : 2;
+        } else
+            break;
+    }
+
+    tokenStart = p;
+    char ch = charAt(p);
+
+    if (isClass(ch, CH_ALPHA)) {
+        int q = p + 1;
+        while (q < dataEnd && q - p < 8 && isClass(data[q], CH_ALPHA | CH_DIGIT))
+            q++;
+        if (q - p == 8) q = scanIdentifier(data, q, dataEnd);
+        tkStr = std::string_view(data + p, q - p);
+        tk = lookupReservedWord(data + p, q - p);
+        if (tk == TOK_ID) {
+            const uint64_t hash = SymbolTable::hash(tkStr);
+            Symbol& cached = symbolCache[hash & 255];
+            if (symbols->name(cached) != tkStr)
+                cached = symbols->intern(tkStr, hash);
+            tkSymbol = cached;
         }
-        if (currCh == 'x') {
+        p = q;
+    } else if (isClass(ch, CH_DIGIT)) {
+        int q = p;
+        bool isHex = false;
+        if (charAt(q) == '0') q++;
+        if (charAt(q) == 'x') {
             isHex = true;
-            tkStr += currCh;
-            getNextCh();
+            q++;
         }
 
         tk = TOK_INT;
-        while (isNumeric(currCh) || (isHex && isHexadecimal(currCh))) {
-            tkStr += currCh;
-            getNextCh();
-        }
+        const unsigned char digits = isHex ? CH_HEX : CH_DIGIT;
+        while (q < dataEnd && isClass(data[q], digits)) q++;
 
-        if (!isHex && currCh == '.') {
+        if (!isHex && charAt(q) == '.') {
             tk = TOK_FLOAT;
-            tkStr += '.';
-            getNextCh();
-            while (isNumeric(currCh)) {
-                tkStr += currCh;
-                getNextCh();
-            }
+            q++;
+            while (q < dataEnd && isClass(data[q], CH_DIGIT)) q++;
         }
 
-        if (!isHex && (currCh == 'e' || currCh == 'E')) {
+        if (!isHex && (charAt(q) == 'e' || charAt(q) == 'E')) {
             tk = TOK_FLOAT;
-            tkStr += currCh;
-            getNextCh();
-
-            if (currCh == '-') {
-                tkStr += currCh;
-                getNextCh();
-            }
-
-            while (isNumeric(currCh)) {
-                tkStr += currCh;
-                getNextCh();
-            }
-        }
-    } else if (currCh == '"') {
-        getNextCh();
-        while (currCh && currCh != '"') {
-            if (currCh == '\\') {
-                getNextCh();
-                switch (currCh) {
-                case 'n': tkStr += '\n'; break;
-                case '"': tkStr += '"'; break;
-                case '\\': tkStr += '\\'; break;
-                default: tkStr += currCh;
-                }
-            } else {
-                tkStr += currCh;
-            }
-            getNextCh();
+            q++;
+            if (charAt(q) == '-') q++;
+            while (q < dataEnd && isClass(data[q], CH_DIGIT)) q++;
         }
 
-        getNextCh();
-        tk = TOK_STR;
-    } else if (currCh == '\'') {
-        // strings again...
-        getNextCh();
-        while (currCh && currCh != '\'') {
-            if (currCh == '\\') {
-                getNextCh();
-                switch (currCh) {
-                case 'n': tkStr += '\n'; break;
-                case 'a': tkStr += '\a'; break;
-                case 'r': tkStr += '\r'; break;
-                case 't': tkStr += '\t'; break;
-                case '\'': tkStr += '\''; break;
-                case '\\': tkStr += '\\'; break;
-                case 'x': { // hex digits
-                    char buf[3] = "??";
-                    getNextCh();
-                    buf[0] = currCh;
-                    getNextCh();
-                    buf[1] = currCh;
-                    tkStr += (char)strtol(buf, 0, 16);
-                } break;
-                default:
-                    if (currCh >= '0' && currCh <= '7') {
-                        // octal digits
-                        char buf[4] = "???";
-                        buf[0] = currCh;
-                        getNextCh();
-                        buf[1] = currCh;
-                        getNextCh();
-                        buf[2] = currCh;
-                        tkStr += (char)strtol(buf, 0, 8);
-                    } else
-                        tkStr += currCh;
-                }
-            } else {
-                tkStr += currCh;
-            }
-            getNextCh();
-        }
-        getNextCh();
+        tkStr = std::string_view(data + p, q - p);
+        p = q;
+    } else if (ch == '"' || ch == '\'') {
+        // Most literals have no escapes and can be a slice of the source,
+        // only decode when there is a backslash before the closing quote.
+        const char quote = ch;
+        int q = scanUntil(data, ++p, dataEnd, quote, '\\', 0);
+        if (charAt(q) == '\\') {
+            q = decodeString(p, quote, escapeBuf);
+            tkStr = escapeBuf;
+        } else
+            tkStr = std::string_view(data + p, q - p);
+        p = q + 1;
         tk = TOK_STR;
     } else {
-        // single chars
-        tk = currCh;
-        if (currCh) getNextCh();
-        if (tk == '=' && currCh == '=') {
-            tk = TOK_EQUAL;
-            getNextCh();
-        } else if (tk == '!' && currCh == '=') {
-            tk = TOK_NEQUAL;
-            getNextCh();
-        } else if (tk == '<' && currCh == '=') {
-            tk = TOK_LEQUAL;
-            getNextCh();
-        } else if (tk == '<' && currCh == '<') {
-            tk = TOK_LSHIFT;
-            getNextCh();
-            if (currCh == '=') {
-                tk = TOK_LSHIFTEQUAL;
-                getNextCh();
-            }
-        } else if (tk == '>' && currCh == '=') {
-            tk = TOK_GEQUAL;
-            getNextCh();
-        } else if (tk == '>' && currCh == '>') {
-            tk = TOK_RSHIFT;
-            getNextCh();
-            if (currCh == '=') {
-                tk = TOK_RSHIFTEQUAL;
-                getNextCh();
-            }
-        } else if (tk == '+' && currCh == '=') {
-            tk = TOK_PLUSEQUAL;
-            getNextCh();
-        } else if (tk == '-' && currCh == '=') {
-            tk = TOK_MINUSEQUAL;
-            getNextCh();
-        } else if (tk == '*' && currCh == '=') {
-            tk = TOK_TIMESEQUAL;
-            getNextCh();
-        } else if (tk == '%' && currCh == '=') {
-            tk = TOK_MODEQUAL;
-            getNextCh();
-        } else if (tk == '/' && currCh == '=') {
-            tk = TOK_DIVIDEEQUAL;
-            getNextCh();
-        } else if (tk == '+' && currCh == '+') {
-            tk = TOK_PLUSPLUS;
-            getNextCh();
-        } else if (tk == '-' && currCh == '-') {
-            tk = TOK_MINUSMINUS;
-            getNextCh();
-        } else if (tk == '&' && currCh == '=') {
-            tk = TOK_ANDEQUAL;
-            getNextCh();
-        } else if (tk == '&' && currCh == '&') {
-            tk = TOK_ANDAND;
-            getNextCh();
-        } else if (tk == '|' && currCh == '=') {
-            tk = TOK_OREQUAL;
-            getNextCh();
-        } else if (tk == '|' && currCh == '|') {
-            tk = TOK_OROR;
-            getNextCh();
-        } else if (tk == '^' && currCh == '=') {
-            tk = TOK_XOREQUAL;
-            getNextCh();
-        } else if (tk == '-' && currCh == '>') {
-            tk = TOK_RSINGLEARROW;
-            getNextCh();
-        } else if (tk == '<' && currCh == '-') {
-            tk = TOK_LSINGLEARROW;
-            getNextCh();
-        } else if (tk == TOK_LEQUAL && currCh == '>') {
-            tk = TOK_SPACESHIP;
-            getNextCh();
-        } else if (tk == ':') {
-            if (currCh == ':') {
-                tk = TOK_COLONCOLON;
-                getNextCh();
-            } else if (currCh == '<') {
-                tk = TOK_GENERIC;
-                getNextCh();
-            }
+        // single chars, then walk the operator table while it has an edge
+        tk = (unsigned char)ch;
+        if (ch) p++;
+        int next;
+        while (tk < TOK_R_LIST_END && opState[tk] &&
+               (unsigned char)charAt(p) < 128 &&
+               (next = opTable[opState[tk]][(unsigned char)charAt(p)])) {
+            tk = next;
+            p++;
         }
     }
 
+    seek(p);
     tokenLastEnd = tokenEnd;
-    tokenEnd = dataPos - 3;
+    tokenEnd = p - 1;
 }
 
-std::string Lexer::getSubString(int lastPosition) {
-    // Fuckshit memory hack
-    int lastCharIdx = tokenLastEnd + 1;
-    if (lastCharIdx < dataEnd) {
-        char old = data[lastCharIdx];
-        data[lastCharIdx] = 0;
-        std::string value = &data[lastPosition];
-        data[lastCharIdx] = old;
-        return value;
-    } else {
-        return std::string(&data[lastPosition]);
+int Lexer::decodeString(int p, char quote, std::string& out) {
+    out.clear();
+    char ch;
+    while ((ch = charAt(p)) && ch != quote) {
+        if (ch != '\\') {
+            out += ch;
+        } else if (quote == '"') {
+            switch (ch = charAt(++p)) {
+            case 'n': out += '\n'; break;
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            default: out += ch;
+            }
+        } else {
+            switch (ch = charAt(++p)) {
+            case 'n': out += '\n'; break;
+            case 'a': out += '\a'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case '\'': out += '\''; break;
+            case '\\': out += '\\'; break;
+            case 'x': { // hex digits
+                char buf[3] = "??";
+                buf[0] = charAt(++p);
+                buf[1] = charAt(++p);
+                out += (char)strtol(buf, 0, 16);
+            } break;
+            default:
+                if (ch >= '0' && ch <= '7') {
+                    // octal digits
+                    char buf[4] = "???";
+                    buf[0] = ch;
+                    buf[1] = charAt(++p);
+                    buf[2] = charAt(++p);
+                    out += (char)strtol(buf, 0, 8);
+                } else
+                    out += ch;
+            }
+        }
+        p++;
     }
+    return p;
+}
+
+// The source between lastPosition and the end of the previous token, as a
+// view, so the buffer is never written to.
+std::string_view Lexer::getSubString(int lastPosition) {
+    const int end = std::min(tokenLastEnd + 1, dataEnd);
+    return std::string_view(data + lastPosition, end - lastPosition);
 }
 
 Lexer* Lexer::getSubLex(int lastPosition) {
-    int lastCharIdx = tokenLastEnd + 1;
-    if (lastCharIdx < dataEnd)
-        return new Lexer(this, lastPosition, lastCharIdx);
-    else
-        return new Lexer(this, lastPosition, dataEnd);
+    return new Lexer(this, lastPosition, std::min(tokenLastEnd + 1, dataEnd));
+}
+
+LineIndex& Lexer::getLines() {
+    return source->getLines();
 }
 
 std::string Lexer::getPosition(int pos) {
     if (pos < 0) pos = tokenLastEnd;
-    int line = 1, col = 1;
-    for (int i = 0; i < pos; i++) {
-        char ch;
-        if (i < dataEnd)
-            ch = data[i];
-        else
-            ch = 0;
-        col++;
-        if (ch == '\n') {
-            line++;
-            col = 0;
-        }
-    }
-    char buf[256];
-    sprintf_s(buf, 256, "(line: %d, col: %d)", line, col);
-    return buf;
+    return getLines().getPosition(pos);
 }
 
 int Lexer::nextToken() {
@@ -9,26 +9,40 @@
 #include "common.h"
 
 #include "exception.h"
+#include "lineindex.h"
+#include "scan.h"
+#include "sourcebuffer.h"
+#include "symbols.h"
 #include "token.h"
 #include "utils.h"
 
 class Lexer {
   public:
     Lexer(const std::string& input);
+    Lexer(SourceBuffer* source);
     Lexer(Lexer* owner, int startChar, int endChar);
     ~Lexer();
 
     char currCh, nextCh;
     int tk, tokenStart, tokenEnd, tokenLastEnd;
-    std::string tkStr;
+    // Text of the current token. Identifiers, numbers and string literals
+    // without escapes are slices of the source; a string literal with
+    // escapes is decoded into a buffer that is reused by the next token.
+    std::string_view tkStr;
+    // Interned name of the current token when it is a TOK_ID, else 0.
+    Symbol tkSymbol;
+
+    // Table identifiers are interned into, SymbolTable::global() by default.
+    SymbolTable* symbols;
 
     void match(int expectedTk);
     static std::string getTokenStr(int token);
     void reset();
 
-    std::string getSubString(int pos);
+    std::string_view getSubString(int pos);
     Lexer* getSubLex(int lastPosition);
 
+    LineIndex& getLines();
     std::string getPosition(int pos = -1);
 
     std::string nextTokenString();
@@ -38,11 +52,23 @@ class Lexer {
     void getNextToken();
 
   protected:
-    char* data;
+    friend class TokenBuffer;
+
+    SourceBuffer* source;
+    bool sourceOwned;
+
+    const char* data;
     int dataStart, dataEnd;
-    bool dataOwned;
 
     int dataPos;
+
+    std::string escapeBuf;
+    // last id seen per hash bucket, most names repeat and skip the lock
+    Symbol symbolCache[256];
+
+    char charAt(int pos);
+    void seek(int pos);
+    int decodeString(int pos, char quote, std::string& out);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,31 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "lineindex.h"
+
+LineIndex::LineIndex(const char* data, int length) {
+    starts.push_back(0);
+    const char* end = data + length;
+    for (const char* p = data;
+         (p = (const char*)memchr(p, '\n', end - p)) != nullptr; p++)
+        starts.push_back(p - data + 1);
+}
+
+int LineIndex::getLine(int offset) {
+    return std::upper_bound(starts.begin(), starts.end(), (uint32_t)offset) -
+           starts.begin();
+}
+
+int LineIndex::getColumn(int offset) {
+    return offset - starts[getLine(offset) - 1] + 1;
+}
+
+std::string LineIndex::getPosition(int offset) {
+    const int line = getLine(offset);
+    char buf[256];
+    sprintf_s(buf, 256, "(line: %d, col: %d)", line,
+              offset - (int)starts[line - 1] + 1);
+    return buf;
+}
@@ -0,0 +1,25 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_LINEINDEX
+#define CAPSTONE_LINEINDEX
+
+#include "common.h"
+
+// Start offset of every line in a source buffer, so that mapping an offset
+// to a line and column is a binary search instead of a rescan.
+class LineIndex {
+  public:
+    LineIndex(const char* data, int length);
+
+    // starts[i] is the offset of the first byte of line i + 1
+    std::vector<uint32_t> starts;
+
+    int getLine(int offset);
+    int getColumn(int offset);
+    std::string getPosition(int offset);
+};
+
+#endif
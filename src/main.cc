@@ -5,35 +5,427 @@
  */
 #include "main.h"
 
-int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " <file.cap>" << std::endl;
-        return 1;
+// What one file printed and whether it compiled. Files run in any order
+// on the pool, their results are printed in the order they were given.
+struct FileResult {
+    std::string output;
+    bool ok = false;
+    bool done = false;
+};
+
+// What compileFile() works with besides the file. Any of the pointers may
+// be nullptr: no cache, no report, or "-" reads the real stdin.
+struct CompileOptions {
+    ParseCache* cache = nullptr;
+    TreeCache* trees = nullptr;
+    TimeReport* report = nullptr;
+    MemoryReport* memory = nullptr;
+    const std::string* input = nullptr;
+    int lexThreads = 1;
+};
+
+// Relative paths of a forwarded command line are relative to the client.
+static std::string resolve(const std::string& cwd, const std::string& path) {
+    if (cwd.empty() || path.empty() || path == "-" || path[0] == '/')
+        return path;
+    return cwd + "/" + path;
+}
+
+// Files named by a path, a directory (every .cap file below it, sorted) or
+// an @response file (one of those per line). An input that cannot be read
+// is reported and the others are still compiled; false if any failed.
+// Subdirectories that may not be read are skipped.
+static bool addInput(const std::string& cwd, const std::string& name,
+                     std::vector<std::string>& files, std::ostream& out) {
+    if (name.size() > 1 && name[0] == '@') {
+        std::ifstream list(resolve(cwd, name.substr(1)));
+        if (!list) {
+            out << "ERROR: " << name.substr(1) << ": Could not open "
+                << name.substr(1) << "\n";
+            return false;
+        }
+        bool ok = true;
+        std::string line;
+        while (std::getline(list, line)) {
+            line = stripWhitespace(line);
+            if (!line.empty()) ok = addInput(cwd, line, files, out) && ok;
+        }
+        return ok;
     }
+    namespace fs = std::filesystem;
+    const std::string arg = resolve(cwd, name);
+    std::error_code error;
+    if (arg == "-" || !fs::is_directory(arg, error)) {
+        files.push_back(arg);
+        return true;
+    }
+    // only the subdirectories are skipped, not the one that was named
+    const fs::directory_iterator top(arg, error);
+    std::vector<std::string> found;
+    fs::recursive_directory_iterator entry;
+    if (!error)
+        entry = fs::recursive_directory_iterator(
+                arg, fs::directory_options::skip_permission_denied, error);
+    for (; !error && entry != fs::recursive_directory_iterator();
+         entry.increment(error)) {
+        std::error_code ignored;
+        if (entry->is_regular_file(ignored) &&
+            entry->path().extension() == ".cap")
+            found.push_back(entry->path().string());
+    }
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    if (error) {
+        out << "ERROR: " << arg << ": Could not read directory: "
+            << error.message() << "\n";
+        return false;
+    }
+    return true;
+}
 
+static bool compileFile(const std::string& fileName,
+                        const CompileOptions& options, std::ostream& out) {
+    // every error names its file, the output of many files is interleaved
+    const std::string where =
+            "ERROR: " + (fileName == "-" ? "<stdin>" : fileName) + ": ";
+    ParseCache* cache = options.cache;
+    TreeCache* trees = options.trees;
+    TimeReport* report = options.report;
+    MemoryReport* memory = options.memory;
     try {
-        const std::string fileName = argv[1];
         const std::string rootName =
                 fileName.substr(0, fileName.find_last_of('.'));
 
-        const std::string source = readFile(fileName);
+        std::unique_ptr<SourceBuffer> source;
+        {
+            PhaseTimer timer(report, TimeReport::LOAD);
+            if (fileName == "-" && options.input)
+                source.reset(new SourceBuffer(*options.input));
+            else
+                source.reset(SourceBuffer::load(fileName));
+        }
+        if (report) {
+            report->files++;
+            report->bytesRead += source->size;
+        }
+
+        if (TRACE_ENABLED(Trace::INFO, Trace::SOURCE))
+            out << std::string_view(source->data, source->size) << "\n\n";
+
+        // trees kept in memory first, then the ones on disk
+        uint64_t key = 0;
+        std::shared_ptr<const FlatTree> kept;
+        std::unique_ptr<FlatFile> cached;
+        if (trees || cache) {
+            PhaseTimer timer(report, TimeReport::CACHE);
+            key = ParseCache::key(*source);
+            if (trees) kept = trees->load(key);
+            if (!kept && cache) cached.reset(cache->load(key));
+        }
+        // A cache entry is copied out first: one another process evicted
+        // since it was mapped, or that cannot be copied for any other
+        // reason, is dropped and the file parsed again.
+        if (cached && fileName != "-") {
+            PhaseTimer timer(report, TimeReport::WRITE);
+            std::error_code error;
+            std::filesystem::copy_file(
+                    cache->path(key), rootName + ".ast",
+                    std::filesystem::copy_options::overwrite_existing, error);
+            if (error) cached.reset();
+        }
+
+        JsonWriter json;
+        if (kept || cached) {
+            const FlatView view = kept ? kept->view() : cached->view();
+            {
+                PhaseTimer timer(report, TimeReport::JSON);
+                view.writeJSON(json);
+            }
+            if (TRACE_ENABLED(Trace::INFO, Trace::JSON))
+                out << json.view() << "\n";
+            if (fileName != "-") {
+                PhaseTimer timer(report, TimeReport::WRITE);
+                dumpStringToFile(rootName + ".json", json.view());
+                size_t written = json.view().size();
+                if (kept)
+                    written += kept->save(rootName + ".ast");
+                else
+                    written += cached->bytes();
+                if (report) report->bytesWritten += written;
+            }
+            if (report) report->countNodes(view);
+            return true;
+        }
+
+        Lexer lex(source.get());
+        TokenBuffer tokens(&lex);
+        {
+            PhaseTimer timer(report, TimeReport::LEX);
+            tokens.tokenizeParallel(options.lexThreads);
+        }
+        if (report) report->tokens += tokens.size();
+        if (TRACE_ENABLED(Trace::DEBUG, Trace::TOKENS))
+            for (size_t i = 0; i < tokens.size(); i++)
+                out << tokens.getPosition(i) << ": "
+                    << Lexer::getTokenStr(tokens.kind(i)) << "\t"
+                    << tokens.text(i) << "\n";
+
+        ParseContext context;
+        Parser parser(&tokens, &context);
+        Node* ast;
+        {
+            PhaseTimer timer(report, TimeReport::PARSE);
+            ast = parser.parse();
+        }
+        if (report) report->countNodes(ast);
+        if (memory) memory->addParse(ast, context.arena, tokens);
+        const Diagnostics& diagnostics = context.diagnostics;
+        if (diagnostics.count()) {
+            for (const std::string& message : diagnostics.messages)
+                out << where << message << "\n";
+            if (diagnostics.dropped)
+                out << where << diagnostics.dropped << " more errors\n";
+            return false;
+        }
+        {
+            PhaseTimer timer(report, TimeReport::JSON);
+            ast->writeJSON(json);
+        }
+        if (TRACE_ENABLED(Trace::INFO, Trace::JSON))
+            out << json.view() << "\n";
+
+        if (fileName != "-" || cache || trees) {
+            std::shared_ptr<FlatTree> flat;
+            {
+                PhaseTimer timer(report, TimeReport::FLATTEN);
+                flat.reset(new FlatTree(ast));
+            }
+            PhaseTimer timer(report, TimeReport::WRITE);
+            size_t written = 0;
+            if (fileName != "-") {
+                dumpStringToFile(rootName + ".json", json.view());
+                written = json.view().size() + flat->save(rootName + ".ast");
+            }
+            if (cache) cache->store(key, *flat);
+            if (trees) trees->store(key, flat);
+            if (report) report->bytesWritten += written;
+        }
+        return true;
+
+    } catch (Exception* e) {
+        out << where << e->text << "\n";
+        delete e;
+        return false;
+    }
+}
+
+// One run of the compiler over a command line, in this process or for a
+// client of the server. Trees kept in `trees` outlive the run.
+static int runDriver(const std::vector<std::string>& args,
+                     const std::string& cwd, const std::string* input,
+                     TreeCache* trees, std::ostream& out, std::ostream& err) {
+    Trace::categories = 0;
+    Trace::level = CAPSTONE_TRACE_LEVEL;
+    Trace::sink = &err;
+
+    std::vector<std::string> files;
+    bool inputsOk = true;
+    std::string cacheDir;
+    uint64_t cacheLimit = ParseCache::defaultLimit;
+    std::string timeReport, memReport;
+    try {
+        for (size_t i = 0; i < args.size(); i++) {
+            const std::string& arg = args[i];
+            if (arg == "--cache-dir" && i + 1 < args.size())
+                cacheDir = resolve(cwd, args[++i]);
+            else if (arg == "--cache-limit" && i + 1 < args.size())
+                cacheLimit = strtoull(args[++i].c_str(), nullptr, 10) << 20;
+            else if (arg == "--time-report")
+                timeReport = "table";
+            else if (arg.rfind("--time-report=", 0) == 0)
+                timeReport = arg.substr(14);
+            else if (arg.rfind("--trace=", 0) == 0) {
+                unsigned named = 0;
+                if (!Trace::enable(arg.substr(8), &named))
+                    throw new Exception("Unknown trace category in " + arg);
+                const std::string off = Trace::compiledOut(named);
+                if (!off.empty())
+                    err << "warning: trace " << off
+                        << " is compiled out, build with "
+                           "CXXFLAGS=-DCAPSTONE_TRACE_LEVEL=2 to use it\n";
+            } else if (arg.rfind("--trace-level=", 0) == 0)
+                Trace::level = atoi(arg.c_str() + 14);
+            else if (arg == "--mem-report")
+                memReport = "table";
+            else if (arg.rfind("--mem-report=", 0) == 0)
+                memReport = arg.substr(13);
+            else
+                inputsOk = addInput(cwd, arg, files, out) && inputsOk;
+        }
+    } catch (Exception* e) {
+        out << "ERROR: " << e->text << "\n";
+        delete e;
+        return 1;
+    }
+    auto badFormat = [](const std::string& format) {
+        return !format.empty() && format != "table" && format != "json";
+    };
+    if (files.empty() && !inputsOk) return 1;
+    if (files.empty() || badFormat(timeReport) || badFormat(memReport)) {
+        out << "Usage: capstone"
+               " [--cache-dir <dir>] [--cache-limit <MB>]"
+               " [--time-report[=table|json]]"
+               " [--mem-report[=table|json]]"
+               " [--trace=source,json,tokens,parser|all]"
+               " [--trace-level=<n>]"
+               " <file.cap | dir | @list | ->...\n"
+               "       capstone --server <socket> <arguments as above>\n"
+               "       capstone --serve <socket> [--memory-limit <MB>]\n";
+        return 1;
+    }
+
+    std::unique_ptr<ParseCache> cache;
+    if (!cacheDir.empty()) cache.reset(new ParseCache(cacheDir, cacheLimit));
+    std::unique_ptr<TimeReport> report;
+    if (!timeReport.empty()) report.reset(new TimeReport());
+    std::unique_ptr<MemoryReport> memory;
+    if (!memReport.empty()) memory.reset(new MemoryReport());
+
+    CompileOptions options;
+    options.cache = cache.get();
+    options.trees = trees;
+    options.report = report.get();
+    options.memory = memory.get();
+    options.input = input;
+
+    // A single file gets the whole machine for lexing and prints as it
+    // goes, many files get a worker each and lex serially.
+    bool ok = true;
+    if (files.size() == 1) {
+        options.lexThreads = std::thread::hardware_concurrency();
+        ok = compileFile(files[0], options, out);
+    } else {
+        std::vector<FileResult> results(files.size());
+        std::mutex lock;
+        std::condition_variable finished;
+        ThreadPool pool(std::min<size_t>(files.size(),
+                                         std::thread::hardware_concurrency()));
+        for (size_t i = 0; i < files.size(); i++)
+            pool.submit([&, i]() {
+                std::ostringstream fileOut;
+                const bool fileOk = compileFile(files[i], options, fileOut);
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    results[i].output = fileOut.str();
+                    results[i].ok = fileOk;
+                    results[i].done = true;
+                }
+                finished.notify_all();
+            });
+
+        for (FileResult& result : results) {
+            std::string output;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                finished.wait(guard, [&]() { return result.done; });
+                output.swap(result.output);
+            }
+            out << output;
+            ok = ok && result.ok;
+        }
+    }
+
+    if (cache)
+        out << "cache: " << cache->hits << " hits, " << cache->misses
+            << " misses" << std::endl;
+
+    // on stderr, so it does not mix with the trees on stdout
+    if (report && timeReport == "json") {
+        JsonWriter json;
+        report->writeJSON(json);
+        err << json.view();
+    } else if (report) {
+        report->print(err);
+    }
+    if (memory && memReport == "json") {
+        JsonWriter json;
+        memory->writeJSON(json);
+        err << json.view();
+    } else if (memory) {
+        memory->print(err);
+    }
+    return ok && inputsOk ? 0 : 1;
+}
 
-        std::cout << source << std::endl;
+// Serves command lines from clients, keeping parsed trees in memory
+// between them. Logs one line per request on its own stderr.
+static int serve(const std::string& socket, uint64_t memoryLimit) {
+    TreeCache trees(memoryLimit);
+    try {
+        CompileServer server(socket, [&](const ServerRequest& request,
+                                         std::ostream& out,
+                                         std::ostream& err) {
+            const size_t hits = trees.hits;
+            const int status = runDriver(request.args, request.cwd,
+                                         &request.input, &trees, out, err);
+            std::cerr << "served " << request.args.size() << " arguments, "
+                      << trees.hits - hits << " trees from memory, "
+                      << trees.size() << " kept in " << trees.bytes()
+                      << " bytes" << std::endl;
+            return status;
+        });
+        std::cerr << "serving on " << socket << std::endl;
+        server.run();
+    } catch (Exception* e) {
+        std::cerr << "ERROR: " << e->text << std::endl;
+        delete e;
+        return 1;
+    }
+    return 0;
+}
 
-        auto lex = new Lexer(source);
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
 
-        // while (lex->tk) {
-        //     std::cout << lex->getPosition() << ": "
-        //               << Lexer::getTokenStr(lex->tk) << "\t" << lex->tkStr <<
-        //               ""
-        //               << std::endl;
-        //     lex->getNextToken();
-        // }
+    if (args.size() >= 2 && args[0] == "--serve") {
+        uint64_t memoryLimit = TreeCache::defaultLimit;
+        if (args.size() >= 4 && args[2] == "--memory-limit")
+            memoryLimit = strtoull(args[3].c_str(), nullptr, 10) << 20;
+        return serve(args[1], memoryLimit);
+    }
 
-        auto parser = new Parser(lex);
-        auto ast = parser->parse();
-        std::cout << "\n\n" + ast->toJSON() << std::endl;
-        dumpStringToFile(rootName + ".json", ast->toJSON());
+    // A client forwards its command line to the server and prints what
+    // came back. Without a server the same command line runs here.
+    std::string server;
+    if (args.size() >= 2 && args[0] == "--server") {
+        server = args[1];
+        args.erase(args.begin(), args.begin() + 2);
+    } else if (const char* env = getenv("CAPSTONE_SERVER")) {
+        server = env;
+    }
+    if (server.empty())
+        return runDriver(args, "", nullptr, nullptr, std::cout, std::cerr);
 
-    } catch (Exception* e) { std::printf("ERROR: %s\n", e->text.c_str()); }
-}
\ No newline at end of file
+    ServerRequest request;
+    request.cwd = std::filesystem::current_path().string();
+    request.args = args;
+    // the server cannot read the client's stdin, so it is sent along
+    if (std::find(args.begin(), args.end(), "-") != args.end())
+        request.input.assign(std::istreambuf_iterator<char>(std::cin),
+                             std::istreambuf_iterator<char>());
+    ServerReply reply;
+    switch (forwardToServer(server, request, reply)) {
+    case REPLIED:
+        std::cout << reply.out << std::flush;
+        std::cerr << reply.err << std::flush;
+        return reply.status;
+    case REPLY_LOST:
+        // running it again here could write the outputs twice
+        std::cerr << "ERROR: " << server
+                  << ": Lost the reply of the compile server" << std::endl;
+        return 1;
+    case NO_SERVER:
+        break;
+    }
+    return runDriver(args, "", &request.input, nullptr, std::cout, std::cerr);
+}
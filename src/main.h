@@ -8,10 +8,21 @@
 
 #include "common.h"
 
+#include <thread>
+
 #include "exception.h"
+#include "flatast.h"
 #include "lexer.h"
+#include "memreport.h"
 #include "parser.h"
+#include "parsecache.h"
+#include "server.h"
+#include "threadpool.h"
+#include "timereport.h"
+#include "trace.h"
 #include "token.h"
+#include "tokenbuffer.h"
+#include "treecache.h"
 #include "utils.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,142 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "memreport.h"
+
+static void addKinds(Node* node, MemoryReport::Kind* kinds) {
+    MemoryReport::Kind& kind = kinds[(int)node->kind];
+    kind.count++;
+    kind.nodeBytes += getNodeSize(node->kind);
+    kind.storageBytes += getNodeStorage(node);
+    forEachChild(node, [&](Node* child) { addKinds(child, kinds); });
+}
+
+// The token buffer does not shrink during a parse, so its size at the end
+// of it is its peak.
+void MemoryReport::addParse(Node* root, Arena& arena, TokenBuffer& tokens) {
+    Kind local[NODE_KINDS];
+    if (root) addKinds(root, local);
+    const size_t tokenBytes = tokens.bytesReserved();
+
+    std::unique_lock<std::mutex> guard(lock);
+    for (int i = 0; i < NODE_KINDS; i++) {
+        kinds[i].count += local[i].count;
+        kinds[i].nodeBytes += local[i].nodeBytes;
+        kinds[i].storageBytes += local[i].storageBytes;
+    }
+    parses++;
+    totalUsed += arena.bytesUsed();
+    totalReserved += arena.bytesReserved();
+    if (arena.bytesPeak() + tokenBytes > peakArena + peakTokens) {
+        currentUsed = arena.bytesUsed();
+        currentReserved = arena.bytesReserved();
+        peakArena = arena.bytesPeak();
+        peakTokens = tokenBytes;
+    }
+}
+
+MemoryReport::Kind MemoryReport::total(void) {
+    Kind sum;
+    for (const Kind& kind : kinds) {
+        sum.count += kind.count;
+        sum.nodeBytes += kind.nodeBytes;
+        sum.storageBytes += kind.storageBytes;
+    }
+    return sum;
+}
+
+static void printLine(std::ostream& out, const char* name, uint64_t count,
+                      uint64_t nodeBytes, uint64_t storageBytes) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-24s %10llu %12llu %12llu %8.1f\n", name,
+             (unsigned long long)count, (unsigned long long)nodeBytes,
+             (unsigned long long)storageBytes,
+             count ? (double)(nodeBytes + storageBytes) / count : 0.0);
+    out << line;
+}
+
+static void printBytes(std::ostream& out, const char* name, uint64_t bytes) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-24s %12llu\n", name,
+             (unsigned long long)bytes);
+    out << line;
+}
+
+void MemoryReport::print(std::ostream& out) {
+    std::unique_lock<std::mutex> guard(lock);
+    char header[128];
+    snprintf(header, sizeof(header), "%-24s %10s %12s %12s %8s\n", "kind",
+             "count", "node bytes", "storage", "average");
+    out << header;
+    for (int i = 0; i < NODE_KINDS; i++)
+        if (kinds[i].count)
+            printLine(out, getNodeKindStr((NodeKind)i).c_str(),
+                      kinds[i].count, kinds[i].nodeBytes,
+                      kinds[i].storageBytes);
+    const Kind sum = total();
+    printLine(out, "total", sum.count, sum.nodeBytes, sum.storageBytes);
+    out << "\n";
+
+    printBytes(out, "parses", parses);
+    printBytes(out, "total arena used", totalUsed);
+    printBytes(out, "total arena reserved", totalReserved);
+    // alignment padding, and nodes that error recovery dropped
+    printBytes(out, "total not in trees",
+               totalUsed - sum.nodeBytes - sum.storageBytes);
+    printBytes(out, "current arena used", currentUsed);
+    printBytes(out, "current arena reserved", currentReserved);
+    printBytes(out, "peak arena", peakArena);
+    printBytes(out, "peak tokens", peakTokens);
+    printBytes(out, "peak total", peakArena + peakTokens);
+}
+
+static void writeCount(JsonWriter& out, const char* name, uint64_t count) {
+    out.write("\"");
+    out.write(name);
+    out.write("\": ");
+    out.write(std::to_string(count));
+}
+
+static void writeKind(JsonWriter& out, const MemoryReport::Kind& kind) {
+    out.write("{");
+    writeCount(out, "count", kind.count);
+    out.write(", ");
+    writeCount(out, "nodeBytes", kind.nodeBytes);
+    out.write(", ");
+    writeCount(out, "storageBytes", kind.storageBytes);
+    out.write("}");
+}
+
+void MemoryReport::writeJSON(JsonWriter& out) {
+    std::unique_lock<std::mutex> guard(lock);
+    out.write("{\"kinds\": {");
+    bool first = true;
+    for (int i = 0; i < NODE_KINDS; i++) {
+        if (!kinds[i].count) continue;
+        if (!first) out.write(", ");
+        first = false;
+        out.write("\"");
+        out.write(getNodeKindStr((NodeKind)i));
+        out.write("\": ");
+        writeKind(out, kinds[i]);
+    }
+    out.write("}, \"total\": ");
+    writeKind(out, total());
+    out.write(", \"arenas\": {");
+    writeCount(out, "parses", parses);
+    out.write(", ");
+    writeCount(out, "used", totalUsed);
+    out.write(", ");
+    writeCount(out, "reserved", totalReserved);
+    out.write("}, \"current\": {");
+    writeCount(out, "arenaUsed", currentUsed);
+    out.write(", ");
+    writeCount(out, "arenaReserved", currentReserved);
+    out.write("}, \"peak\": {");
+    writeCount(out, "arena", peakArena);
+    out.write(", ");
+    writeCount(out, "tokens", peakTokens);
+    out.write("}}\n");
+}
@@ -0,0 +1,48 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_MEMREPORT
+#define CAPSTONE_MEMREPORT
+
+#include "common.h"
+
+#include "ast.h"
+#include "tokenbuffer.h"
+
+// Memory held by parsed trees, per node kind, for --mem-report. A parse is
+// added once it is done: its tree is walked for the count, record bytes
+// and arena storage (child arrays and strings) of each kind, and its arena
+// and token buffer give what the parse held in total. Kinds and arena
+// totals are summed over every parse of the run; current and peak bytes
+// are those of the largest parse, at its end and at its high point.
+class MemoryReport {
+  public:
+    struct Kind {
+        uint64_t count = 0;
+        uint64_t nodeBytes = 0;
+        uint64_t storageBytes = 0;
+    };
+
+    void addParse(Node* root, Arena& arena, TokenBuffer& tokens);
+
+    // A table for people, or one JSON object with the same numbers.
+    void print(std::ostream& out);
+    void writeJSON(JsonWriter& out);
+
+  private:
+    std::mutex lock;
+    Kind kinds[NODE_KINDS];
+    uint64_t parses = 0;
+    // arena bytes of every parse, summed
+    uint64_t totalUsed = 0, totalReserved = 0;
+    // the largest parse: what its tree keeps once it is over, and the most
+    // arena and token bytes it held
+    uint64_t currentUsed = 0, currentReserved = 0;
+    uint64_t peakArena = 0, peakTokens = 0;
+
+    Kind total(void);
+};
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "parsecache.h"
+
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "symbols.h"
+
+namespace fs = std::filesystem;
+
+ParseCache::ParseCache(const std::string& dir, uint64_t limit)
+    : hits(0), misses(0), dir(dir), limit(limit), temps(0), used(0),
+      scanned(false) {
+    std::error_code error;
+    fs::create_directories(dir, error);
+}
+
+uint64_t ParseCache::key(const SourceBuffer& source) {
+    uint64_t h = SymbolTable::hash(std::string_view(source.data, source.size));
+    h = (h ^ SymbolTable::hash(CAPSTONE_VERSION)) * 0xBF58476D1CE4E5B9ull;
+    h = (h ^ FLAT_VERSION) * 0x94D049BB133111EBull;
+    h = (h ^ FLAT_LAYOUT) * 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 31);
+}
+
+std::string ParseCache::path(uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ast", (unsigned long long)key);
+    return dir + "/" + name;
+}
+
+FlatFile* ParseCache::load(uint64_t key) {
+    const std::string file = path(key);
+    FlatFile* tree = nullptr;
+    if (access(file.c_str(), R_OK) == 0) {
+        try {
+            tree = FlatFile::load(file);
+        } catch (Exception* e) {
+            // an entry from another version or a damaged one, drop it
+            delete e;
+            unlink(file.c_str());
+        }
+    }
+    if (!tree) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    utime(file.c_str(), nullptr);
+    return tree;
+}
+
+void ParseCache::store(uint64_t key, const FlatTree& tree) {
+    const std::string file = path(key);
+    const std::string temp = file + "." + std::to_string(getpid()) + "." +
+                             std::to_string(temps++) + ".tmp";
+    size_t bytes;
+    try {
+        bytes = tree.save(temp);
+    } catch (Exception* e) {
+        delete e;
+        unlink(temp.c_str());
+        return;
+    }
+    if (rename(temp.c_str(), file.c_str()) != 0) {
+        unlink(temp.c_str());
+        return;
+    }
+    bool full;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        used += bytes;
+        full = !scanned || used > limit;
+    }
+    if (full) evict();
+}
+
+// Least recently used first, until the directory is 3/4 of the limit so
+// that every store does not trigger another pass.
+void ParseCache::evict(void) {
+    std::lock_guard<std::mutex> guard(lock);
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        time_t used;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    for (auto& item : fs::directory_iterator(dir, error)) {
+        struct stat st;
+        if (stat(item.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        entries.push_back({item.path().string(), (uint64_t)st.st_size,
+                           st.st_mtime});
+        total += st.st_size;
+    }
+    scanned = true;
+    used = total;
+    if (total <= limit) return;
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& entry : entries) {
+        if (total <= limit / 4 * 3) break;
+        if (unlink(entry.path.c_str()) == 0) total -= entry.size;
+    }
+    used = total;
+}
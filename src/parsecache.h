@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_PARSECACHE
+#define CAPSTONE_PARSECACHE
+
+#include "common.h"
+
+#include <atomic>
+#include <mutex>
+
+#include "flatast.h"
+#include "sourcebuffer.h"
+
+// Directory of saved flat trees keyed by a hash of the source bytes, the
+// compiler version and the tree file format, so any change to one of them
+// is a miss. Entries are written to a temporary file and renamed into
+// place, which makes them appear whole or not at all to other processes
+// and threads sharing the directory. Hits refresh the entry's modification
+// time and the oldest entries are removed once the directory grows past
+// its limit. The directory is listed by the first store and then only
+// when the bytes stored since may have crossed the limit. Failing to
+// write or evict is not an error, the entry is just not cached.
+class ParseCache {
+  public:
+    static const uint64_t defaultLimit = 256 << 20;
+
+    ParseCache(const std::string& dir, uint64_t limit = defaultLimit);
+
+    static uint64_t key(const SourceBuffer& source);
+
+    // the cached tree, or nullptr on a miss
+    FlatFile* load(uint64_t key);
+    void store(uint64_t key, const FlatTree& tree);
+    void evict(void);
+
+    std::string path(uint64_t key);
+
+    std::atomic<size_t> hits, misses;
+
+  private:
+    std::string dir;
+    uint64_t limit;
+    // numbers the temporary files of concurrent stores
+    std::atomic<uint64_t> temps;
+    // guards used and scanned, and serializes evictions
+    std::mutex lock;
+    // bytes in the directory at the last listing plus those stored since
+    uint64_t used;
+    bool scanned;
+};
+
+#endif
@@ -5,191 +5,311 @@
  */
 #include "parser.h"
 
+#include <array>
+
+#include "trace.h"
+
+Parser::Parser(Lexer* lexer, ParseContext* context)
+    : peeks(0), context(context), tokens(new TokenBuffer(lexer)),
+      tokensOwned(true), cursor(0), lastError(SIZE_MAX) {
+    tk = peek(0);
+}
+
+Parser::Parser(TokenBuffer* tokens, ParseContext* context)
+    : peeks(0), context(context), tokens(tokens), tokensOwned(false),
+      cursor(tokens->first), lastError(SIZE_MAX) {
+    tk = peek(0);
+}
+
+Parser::~Parser() {
+    if (tokensOwned) delete tokens;
+}
+
 Node* Parser::parse(void) {
     return parseFile();
 }
 
+int Parser::peek(int k) {
+    peeks++;
+    return tokens->kind(cursor + k);
+}
+
+std::string_view Parser::tkStr(void) {
+    return tokens->text(cursor);
+}
+
+Symbol Parser::tkSymbol(void) {
+    return tokens->symbol(cursor);
+}
+
+void Parser::next(void) {
+    tk = peek(1);
+    cursor++;
+    // a streaming parser only keeps a window behind the cursor, or behind
+    // the oldest mark it may still rewind to
+    const size_t keep = marks.empty() ? cursor : marks.front();
+    if (tokensOwned && keep - tokens->first >= 4096) tokens->release(keep);
+}
+
+void Parser::match(int expectedTk) {
+    if (tk != expectedTk)
+        error("Got " + Lexer::getTokenStr(tk) + " expected " +
+              Lexer::getTokenStr(expectedTk) + " at " +
+              tokens->getPosition(cursor));
+    next();
+}
+
+// Unwinds to the innermost list being parsed (file, class body or block),
+// which calls recover(). Thrown by value, so nothing is leaked.
+struct Panic {
+    std::string message;
+};
+
+// A token that already failed is reported once, not again by every list
+// it unwinds out of.
+void Parser::error(const std::string& message) {
+    if (cursor != lastError) context->diagnostics.add(message);
+    lastError = cursor;
+    throw Panic{message};
+}
+
+static bool isDeclaration(int tk) {
+    return tk == TOK_R_FUNC || tk == TOK_R_CLASS || tk == TOK_R_IMPORT ||
+           tk == TOK_R_ENUM;
+}
+
+// Skip to where the list that caught the panic can carry on, always past
+// at least one token so that the same error cannot repeat forever.
+Node* Parser::recover(size_t start, const std::string& message) {
+    auto node = make<SyntaxError>(message);
+    while (tk != TOK_EOF && tk != '}' && !isDeclaration(tk)) {
+        const bool end = tk == ';';
+        next();
+        if (end) return node;
+    }
+    if (cursor == start && tk != TOK_EOF) next();
+    return node;
+}
+
+size_t Parser::mark(void) {
+    marks.push_back(cursor);
+    return cursor;
+}
+
+void Parser::rewind(size_t position) {
+    assert(position >= tokens->first && position <= cursor);
+    unmark();
+    cursor = position;
+    tk = peek(0);
+}
+
+void Parser::unmark(void) {
+    marks.pop_back();
+}
+
 Node* Parser::parseFile(void) {
     std::vector<Node*> nodes;
-    while (lexer->tk != TOK_EOF) nodes.push_back(parseGlobalScope());
-    return new Block(nodes);
+    while (tk != TOK_EOF) {
+        const size_t start = cursor;
+        try {
+            nodes.push_back(parseGlobalScope());
+            if (cursor == start)
+                error("Unexpected " + Lexer::getTokenStr(tk) + " at " +
+                      tokens->getPosition(cursor));
+        } catch (Panic& panic) {
+            nodes.push_back(recover(start, panic.message));
+        }
+    }
+    return make<Block>(nodes);
 }
 
 Node* Parser::parseGlobalScope(void) {
-    if (lexer->tk == TOK_R_FUNC)
+    if (tk == TOK_R_FUNC)
         return parseFuncDecl();
-    else if (lexer->tk == TOK_R_IMPORT)
+    else if (tk == TOK_R_IMPORT)
         return parseImport();
-    else if (lexer->tk == TOK_R_ENUM)
+    else if (tk == TOK_R_ENUM)
         return parseEnumDecl();
-    else if (lexer->tk == TOK_R_CLASS)
+    else if (tk == TOK_R_CLASS)
         return parseClassDecl();
     else
         return parseBlockOrStatement();
 }
 
 Node* Parser::parseEnumDecl(void) {
-    lexer->match(TOK_R_ENUM);
+    match(TOK_R_ENUM);
     Node* name = parseTypeIdent();
     std::vector<Node*> nodes;
     
-    lexer->match('{');
-    if (lexer->tk != '{') {
+    match('{');
+    if (tk != '{') {
         nodes.push_back(parseVarIdent());
-        while (lexer->tk == ',') {
-            lexer->match(',');
+        while (tk == ',') {
+            match(',');
             nodes.push_back(parseVarIdent());
         }
     }
-    lexer->match('}');
+    match('}');
     
-    return new EnumDeclaration(name, nodes);
+    return make<EnumDeclaration>(name, nodes);
 }
 
 Node* Parser::parseClassDecl(void) {
-    lexer->match(TOK_R_CLASS);
+    match(TOK_R_CLASS);
     Node* name = parseTypeIdent();
     Node* super = nullptr;
-    if (lexer->tk == ':') {
-        lexer->match(':');
+    if (tk == ':') {
+        match(':');
         super = parseTypeIdent();
     }
     Node* body = parseClassBody();
-    return new ClassDeclaration(name, super, body);
+    return make<ClassDeclaration>(name, super, body);
 }
 
 Node* Parser::parseClassBody(void) {
-    lexer->match('{');
+    match('{');
     std::vector<Node*> fields;
-    while (lexer->tk != '}') fields.push_back(parseClassField());
-    lexer->match('}');
-    return new Block(fields);
+    // methods start with func, any other declaration means a missing `}`
+    while (tk != '}' && tk != TOK_EOF &&
+           (tk == TOK_R_FUNC || !isDeclaration(tk))) {
+        const size_t start = cursor;
+        try {
+            fields.push_back(parseClassField());
+            if (cursor == start)
+                error("Unexpected " + Lexer::getTokenStr(tk) + " at " +
+                      tokens->getPosition(cursor));
+        } catch (Panic& panic) {
+            fields.push_back(recover(start, panic.message));
+        }
+    }
+    match('}');
+    return make<Block>(fields);
 }
 
 Node* Parser::parseClassField(void) {
     unsigned int staticness = 0;
-    if (lexer->tk == TOK_R_PRIVATE) {
-        lexer->match(TOK_R_PRIVATE);
-        if (lexer->tk == TOK_R_STATIC) {
-            lexer->match(TOK_R_STATIC);
+    if (tk == TOK_R_PRIVATE) {
+        match(TOK_R_PRIVATE);
+        if (tk == TOK_R_STATIC) {
+            match(TOK_R_STATIC);
             staticness = 1;
         }
-        return new ClassField(parseClassMember(), 0, staticness);
-    } else if (lexer->tk == TOK_R_PROTECTED) {
-        lexer->match(TOK_R_PROTECTED);
-        if (lexer->tk == TOK_R_STATIC) {
-            lexer->match(TOK_R_STATIC);
+        return make<ClassField>(parseClassMember(), 0, staticness);
+    } else if (tk == TOK_R_PROTECTED) {
+        match(TOK_R_PROTECTED);
+        if (tk == TOK_R_STATIC) {
+            match(TOK_R_STATIC);
             staticness = 1;
         }
-        return new ClassField(parseClassMember(), 1, staticness);
-    } else if (lexer->tk == TOK_R_PUBLIC) {
-        lexer->match(TOK_R_PUBLIC);
-        if (lexer->tk == TOK_R_STATIC) {
-            lexer->match(TOK_R_STATIC);
+        return make<ClassField>(parseClassMember(), 1, staticness);
+    } else if (tk == TOK_R_PUBLIC) {
+        match(TOK_R_PUBLIC);
+        if (tk == TOK_R_STATIC) {
+            match(TOK_R_STATIC);
             staticness = 1;
         }
-        return new ClassField(parseClassMember(), 2, staticness);
+        return make<ClassField>(parseClassMember(), 2, staticness);
     } else {
-         if (lexer->tk == TOK_R_STATIC) {
-            lexer->match(TOK_R_STATIC);
+         if (tk == TOK_R_STATIC) {
+            match(TOK_R_STATIC);
             staticness = 1;
         }
-        return new ClassField(parseClassMember(), 0, staticness);
+        return make<ClassField>(parseClassMember(), 0, staticness);
     }
 }
 
 
 
 Node* Parser::parseClassMember(void) {
-    if (lexer->tk == TOK_R_FUNC)
+    if (tk == TOK_R_FUNC)
         return parseFuncDecl();
     else
         return parseExpressionStatement();
 }
 
 Node* Parser::parseImport(void) {
-    lexer->match(TOK_R_IMPORT);
+    match(TOK_R_IMPORT);
     Node* package = parseVarIdent();
-    lexer->match(';');
-    return new ImportStatement(package);
+    match(';');
+    return make<ImportStatement>(package);
 }
 
 Node* Parser::parseFuncDecl(void) {
     Node* generic = NULL;
-    lexer->match(TOK_R_FUNC);
+    match(TOK_R_FUNC);
 
     Node* name = parseVarIdent();
-    if (lexer->tk == '<') {
-        lexer->match('<');
-        if (lexer->tk != '>') generic = parseTypeIdent();
+    if (tk == '<') {
+        match('<');
+        if (tk != '>') generic = parseTypeIdent();
     }
-    lexer->match('(');
+    match('(');
     std::vector<Node*> params;
-    if (lexer->tk != ')') {
+    if (tk != ')') {
         params.push_back(parseParamDecl());
-        while (lexer->tk == ',') {
-            lexer->match(',');
+        while (tk == ',') {
+            match(',');
             params.push_back(parseParamDecl());
         }
     }
-    lexer->match(')');
+    match(')');
     std::vector<Node*> returns;
-    if (lexer->tk == TOK_ID)
+    if (tk == TOK_ID)
         returns.push_back(parseTypeIdent());
-    else if (lexer->tk == '(') {
-        lexer->match('(');
+    else if (tk == '(') {
+        match('(');
         returns.push_back(parseTypeIdent());
-        while (lexer->tk == ',') {
-            lexer->match(',');
+        while (tk == ',') {
+            match(',');
             returns.push_back(parseTypeIdent());
         }
-        lexer->match(')');
+        match(')');
     }
     Node* body = parseBlock();
-    return new FunctionDeclaration(name, generic, params, returns, body);
+    return make<FunctionDeclaration>(name, generic, params, returns, body);
 }
 
 Node* Parser::parseVarIdent(void) {
-    const std::string name = lexer->tkStr;
-    lexer->match(TOK_ID);
-    auto var = new VariableIdentifier(NULL, name);
-    if (lexer->tk == '.') {
-        lexer->match('.');
+    const Symbol name = tkSymbol();
+    match(TOK_ID);
+    auto var = make<VariableIdentifier>(nullptr, name);
+    if (tk == '.') {
+        match('.');
         var->child = parseVarIdent();
     }
     return var;
 }
 
 Node* Parser::parseTypeIdent(void) {
-    const bool isConst = lexer->tk == TOK_R_CONST;
-    if (isConst) lexer->match(TOK_R_CONST);
-    const std::string name = lexer->tkStr;
-    lexer->match(TOK_ID);
+    const bool isConst = tk == TOK_R_CONST;
+    if (isConst) match(TOK_R_CONST);
+    const Symbol name = tkSymbol();
+    match(TOK_ID);
     std::vector<Node*> children;
-    if (lexer->tk == '<') {
-        lexer->match('<');
+    if (tk == '<') {
+        match('<');
         children.push_back(parseTypeIdent());
-        while (lexer->tk == ',') {
-            lexer->match(',');
+        while (tk == ',') {
+            match(',');
             children.push_back(parseTypeIdent());
         }
 
-        if (lexer->tk == TOK_RSHIFT)
-            lexer->match(TOK_RSHIFT);
-        else if (lexer->tk == '>')
-            lexer->match('>');
+        if (tk == TOK_RSHIFT)
+            match(TOK_RSHIFT);
+        else if (tk == '>')
+            match('>');
         else
             ;
-        // throw new Exception("Got " + Lexer::getTokenStr(lexer->tk) + "
+        // throw new Exception("Got " + Lexer::getTokenStr(tk) + "
         // expected " +
         //                 Lexer::getTokenStr('>') + " at " +
-        //                 lexer->getPosition(lexer->tokenStart));
+        //                 tokens->getPosition(cursor));
     }
 
-    auto type = new TypeIdentifier(children, name, 0, isConst ? 1 : 0);
-    while (lexer->tk == '[') {
-        lexer->match('[');
-        lexer->match(']');
+    auto type = make<TypeIdentifier>(children, name, 0, isConst ? 1 : 0);
+    while (tk == '[') {
+        match('[');
+        match(']');
         type->list++;
     }
     return type;
@@ -197,298 +317,339 @@ Node* Parser::parseTypeIdent(void) {
 
 Node* Parser::parseParamDecl(void) {
     Node* var = parseVarIdent();
-    lexer->match(':');
-    return new ParameterDeclaration(var, parseTypeIdent());
+    match(':');
+    return make<ParameterDeclaration>(var, parseTypeIdent());
 }
 
 Node* Parser::parseBlockOrStatement(void) {
-    return lexer->tk == '{' ? parseBlock() : parseStatement();
+    return tk == '{' ? parseBlock() : parseStatement();
 }
 
 Node* Parser::parseBlock(void) {
-    lexer->match('{');
+    match('{');
     std::vector<Node*> statements;
-    while (lexer->tk != '}') statements.push_back(parseStatement());
-    lexer->match('}');
-    return new Block(statements);
+    while (tk != '}' && tk != TOK_EOF && !isDeclaration(tk)) {
+        const size_t start = cursor;
+        try {
+            statements.push_back(parseStatement());
+            if (cursor == start)
+                error("Unexpected " + Lexer::getTokenStr(tk) + " at " +
+                      tokens->getPosition(cursor));
+        } catch (Panic& panic) {
+            statements.push_back(recover(start, panic.message));
+        }
+    }
+    match('}');
+    return make<Block>(statements);
 }
 
 Node* Parser::parseStatement(void) {
-    if (lexer->tk == TOK_R_IF)
+    if (tk == TOK_R_IF)
         return parseIfElseStatement();
-    else if (lexer->tk == TOK_R_WHILE)
+    else if (tk == TOK_R_WHILE)
         return parseWhileStatement();
-    else if (lexer->tk == TOK_R_FOR)
+    else if (tk == TOK_R_FOR)
         return parseForStatement();
-    else if (lexer->tk == TOK_R_BREAK)
+    else if (tk == TOK_R_BREAK)
         return parseBreakStatement();
-    else if (lexer->tk == TOK_R_CONTINUE)
+    else if (tk == TOK_R_CONTINUE)
         return parseContinueStatement();
-    else if (lexer->tk == TOK_R_RETURN)
+    else if (tk == TOK_R_RETURN)
         return parseReturnStatement();
     else
         return parseExpressionStatement();
 }
 
 Node* Parser::parseIfElseStatement(void) {
-    lexer->match(TOK_R_IF);
-    lexer->match('(');
+    match(TOK_R_IF);
+    match('(');
     Node* condition = parseExpression();
-    lexer->match(')');
+    match(')');
     Node* ifStatement = parseBlockOrStatement();
     Node* elseStatement = nullptr;
-    if (lexer->tk == TOK_R_ELSE) {
-        lexer->match(TOK_R_ELSE);
+    if (tk == TOK_R_ELSE) {
+        match(TOK_R_ELSE);
         elseStatement = parseBlockOrStatement();
     }
-    return new IfElseStatement(condition, ifStatement, elseStatement);
+    return make<IfElseStatement>(condition, ifStatement, elseStatement);
 }
 
 Node* Parser::parseWhileStatement(void) {
-    lexer->match(TOK_R_WHILE);
-    lexer->match('(');
+    match(TOK_R_WHILE);
+    match('(');
     Node* condition = parseExpression();
-    lexer->match(')');
+    match(')');
     Node* block = parseBlockOrStatement();
-    return new WhileStatement(condition, block);
+    return make<WhileStatement>(condition, block);
 }
 
 Node* Parser::parseForStatement(void) {
-    lexer->match(TOK_R_FOR);
-    lexer->match('(');
-    Node* init = lexer->tk != ';' ? parseExpressionStatement() : NULL;
+    match(TOK_R_FOR);
+    match('(');
+    Node* init = tk != ';' ? parseExpressionStatement() : NULL;
     Node* condition = parseExpression();
-    lexer->match(';');
-    Node* post = lexer->tk != ';' ? parseExpression() : NULL;
-    lexer->match(')');
+    match(';');
+    Node* post = tk != ';' ? parseExpression() : NULL;
+    match(')');
     Node* block = parseBlockOrStatement();
-    return new ForStatement(init, condition, post, block);
+    return make<ForStatement>(init, condition, post, block);
 }
 
 Node* Parser::parseBreakStatement(void) {
-    lexer->match(TOK_R_BREAK);
-    lexer->match(';');
-    return new BreakStatement();
+    match(TOK_R_BREAK);
+    match(';');
+    return make<BreakStatement>();
 }
 
 Node* Parser::parseContinueStatement(void) {
-    lexer->match(TOK_R_CONTINUE);
-    lexer->match(';');
-    return new ContinueStatement();
+    match(TOK_R_CONTINUE);
+    match(';');
+    return make<ContinueStatement>();
 }
 
 Node* Parser::parseReturnStatement(void) {
-    lexer->match(TOK_R_RETURN);
+    match(TOK_R_RETURN);
     std::vector<Node*> nodes;
-    if (lexer->tk != ';') {
+    if (tk != ';') {
         nodes.push_back(parseExpression());
-        while (lexer->tk == ',') {
-            lexer->match(',');
+        while (tk == ',') {
+            match(',');
             nodes.push_back(parseExpression());
         }
     }
-    lexer->match(';');
-    return new ReturnStatement(nodes);
+    match(';');
+    return make<ReturnStatement>(nodes);
 }
 
 Node* Parser::parseExpressionStatement(void) {
-    LOG(1);
-    if (lexer->tk == ';') {
-        lexer->match(';');
+    TRACE(Trace::DEBUG, Trace::PARSER,
+          "expression statement at " << tokens->getPosition(cursor));
+    if (tk == ';') {
+        match(';');
         return NULL;
     }
-    LOG(2);
-    if (lexer->tk == TOK_R_VAR || lexer->tk == TOK_R_CONST) 
+    if (tk == TOK_R_VAR || tk == TOK_R_CONST) 
         return parseVarDecl();
     else
         return parseExpression();
 }
 
 Node* Parser::parseVarDecl(void) {
-    LOG(3);
-    const bool isConst = lexer->tk == TOK_R_CONST;
-    lexer->match(isConst ? TOK_R_CONST : TOK_R_VAR);
+    TRACE(Trace::DEBUG, Trace::PARSER,
+          "variable declaration at " << tokens->getPosition(cursor));
+    const bool isConst = tk == TOK_R_CONST;
+    match(isConst ? TOK_R_CONST : TOK_R_VAR);
     const unsigned int nConst = isConst ? 1 : 0;
     Node* name = parseVarIdent();
     Node* type = nullptr;
-    if (lexer->tk == ':') {
-        lexer->match(':');
+    if (tk == ':') {
+        match(':');
         type = parseTypeIdent();
     }
-    if (lexer->tk == ';') {
-        lexer->match(';');
-        return new VariableDeclaration(nConst, type, name, NULL);
+    if (tk == ';') {
+        match(';');
+        return make<VariableDeclaration>(nConst, type, name, nullptr);
     } else {
-        lexer->match('=');
+        match('=');
         auto value = parseExpression();
-        lexer->match(';');
-        return new VariableDeclaration(nConst, type, name, value);
+        match(';');
+        return make<VariableDeclaration>(nConst, type, name, value);
     }
 }
 
 
 
-Node* Parser::parseExpression(void) {
-    return parseTernaryExpression();
-}
-
-Node* Parser::parseTernaryExpression(void) {
-    Node* condition = parseAssignExpression();
-    if (lexer->tk != '?') return condition;
-    lexer->match('?');
-    Node* ifTrue = parseExpression();
-    lexer->match(':');
-    Node* ifFalse = parseExpression();
-    return new TernaryExpression(condition, ifTrue, ifFalse);
-}
-
-Node* Parser::parseAssignExpression(void) {
-    return parseBinaryOperator({'=', TOK_PLUSEQUAL, TOK_MINUSEQUAL,
-                                TOK_TIMESEQUAL, TOK_DIVIDEEQUAL, TOK_MODEQUAL,
-                                TOK_LSHIFTEQUAL, TOK_RSHIFTEQUAL, TOK_ANDEQUAL,
-                                TOK_OREQUAL, TOK_XOREQUAL},
-                               &Parser::parseLogicalOr);
-}
-
-Node* Parser::parseLogicalOr(void) {
-    return parseBinaryOperator(TOK_OROR, &Parser::parseLogicalAnd);
-}
-
-Node* Parser::parseLogicalAnd(void) {
-    return parseBinaryOperator(TOK_ANDAND, &Parser::parseEquality);
-}
-
-Node* Parser::parseBitwiseOr(void) {
-    return parseBinaryOperator('|', &Parser::parseBitwiseXor);
-}
-
-Node* Parser::parseBitwiseXor(void) {
-    return parseBinaryOperator('^', &Parser::parseBitwiseAnd);
-}
-
-Node* Parser::parseBitwiseAnd(void) {
-    return parseBinaryOperator('&', &Parser::parseEquality);
-}
-
-Node* Parser::parseEquality(void) {
-    return parseBinaryOperator({TOK_EQUAL, TOK_NEQUAL},
-                               &Parser::parseRelational);
-}
-
-Node* Parser::parseRelational(void) {
-    return parseBinaryOperator(
-            {TOK_SPACESHIP, '>', '<', TOK_GEQUAL, TOK_LEQUAL},
-            &Parser::parseShift);
-}
-
-Node* Parser::parseShift(void) {
-    return parseBinaryOperator({TOK_RSHIFT, TOK_LSHIFT},
-                               &Parser::parseAdditive);
-}
-
-Node* Parser::parseAdditive(void) {
-    return parseBinaryOperator({'+', '-'}, &Parser::parseMultiplicative);
-}
-
-Node* Parser::parseMultiplicative(void) {
-    return parseBinaryOperator({'*', '/', '%'}, &Parser::parseUnaryExpression);
+// Precedence levels from the readme's operator table, loosest first.
+enum Precedence {
+    PREC_NONE,
+    PREC_ASSIGN,
+    PREC_TERNARY,
+    PREC_LOGICAL_OR,
+    PREC_LOGICAL_AND,
+    PREC_BITWISE_OR,
+    PREC_BITWISE_XOR,
+    PREC_BITWISE_AND,
+    PREC_EQUALITY,
+    PREC_RELATIONAL,
+    PREC_SHIFT,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE,
+};
+
+// An operator at level L binds its left operand with 2L. The right side
+// is parsed with 2L + 1 for left associative operators, so an equal
+// operator after it ends the operand, and with 2L for right associative
+// ones. 0 means the token is not a binary operator.
+struct BindingPower {
+    unsigned char left, right;
+};
+
+static constexpr std::array<BindingPower, TOK_R_LIST_END> bindingPowers(void) {
+    std::array<BindingPower, TOK_R_LIST_END> table{};
+    auto leftAssoc = [&](int level, std::initializer_list<int> ops) {
+        for (int op : ops)
+            table[op] = {(unsigned char)(2 * level),
+                         (unsigned char)(2 * level + 1)};
+    };
+    auto rightAssoc = [&](int level, std::initializer_list<int> ops) {
+        for (int op : ops)
+            table[op] = {(unsigned char)(2 * level),
+                         (unsigned char)(2 * level)};
+    };
+    rightAssoc(PREC_ASSIGN, {'=', TOK_PLUSEQUAL, TOK_MINUSEQUAL,
+                             TOK_TIMESEQUAL, TOK_DIVIDEEQUAL, TOK_MODEQUAL,
+                             TOK_LSHIFTEQUAL, TOK_RSHIFTEQUAL, TOK_ANDEQUAL,
+                             TOK_XOREQUAL, TOK_OREQUAL});
+    rightAssoc(PREC_TERNARY, {'?'});
+    leftAssoc(PREC_LOGICAL_OR, {TOK_OROR});
+    leftAssoc(PREC_LOGICAL_AND, {TOK_ANDAND});
+    leftAssoc(PREC_BITWISE_OR, {'|'});
+    leftAssoc(PREC_BITWISE_XOR, {'^'});
+    leftAssoc(PREC_BITWISE_AND, {'&'});
+    leftAssoc(PREC_EQUALITY, {TOK_EQUAL, TOK_NEQUAL});
+    leftAssoc(PREC_RELATIONAL,
+              {'<', '>', TOK_LEQUAL, TOK_GEQUAL, TOK_SPACESHIP});
+    leftAssoc(PREC_SHIFT, {TOK_LSHIFT, TOK_RSHIFT});
+    leftAssoc(PREC_ADDITIVE, {'+', '-'});
+    leftAssoc(PREC_MULTIPLICATIVE, {'*', '/', '%'});
+    return table;
+}
+
+static constexpr std::array<BindingPower, TOK_R_LIST_END> binding =
+        bindingPowers();
+
+Node* Parser::parseExpression(int minPower) {
+    Node* node = parseUnaryExpression();
+    for (;;) {
+        const BindingPower power =
+                tk < TOK_R_LIST_END ? binding[tk] : BindingPower{0, 0};
+        if (!power.left || power.left < minPower) break;
+        const int op = tk;
+        next();
+        if (op == '?') {
+            Node* ifTrue = parseExpression();
+            match(':');
+            Node* ifFalse = parseExpression(power.right);
+            node = make<TernaryExpression>(node, ifTrue, ifFalse);
+        } else {
+            Node* right = parseExpression(power.right);
+            node = make<BinaryOperator>(node, right, op);
+        }
+    }
+    return node;
 }
 
 Node* Parser::parseUnaryExpression(void) {
-    if (lexer->tk == '!' || lexer->tk == '$' || lexer->tk == '#' || lexer->tk == '@') {
-        const int op = lexer->tk;
-        lexer->match(lexer->tk);
-        return new UnaryOperator(parseElement(), op);
+    if (tk == '!' || tk == '$' || tk == '#' || tk == '@') {
+        const int op = tk;
+        next();
+        return make<UnaryOperator>(parseElement(), op);
     } else
         return parseElement();
 }
 
 Node* Parser::parseElement(void) {
-    if (lexer->tk == TOK_INT || lexer->tk == TOK_FLOAT) {
-        auto num = new NumberLiteral(lexer->tkStr);
-        lexer->match(lexer->tk);
+    if (tk == TOK_INT || tk == TOK_FLOAT) {
+        auto num = make<NumberLiteral>(tkStr());
+        next();
         return num;
-    } else if (lexer->tk == TOK_STR) {
-        auto str = new StringLiteral(lexer->tkStr);
-        lexer->match(lexer->tk);
+    } else if (tk == TOK_STR) {
+        auto str = make<StringLiteral>(tkStr());
+        next();
         return str;
-    } else if (lexer->tk == TOK_R_TRUE || lexer->tk == TOK_R_FALSE) {
-        auto boolean = new BooleanLiteral(lexer->tk == TOK_R_TRUE ? "1" : "0");
-        lexer->match(lexer->tk);
+    } else if (tk == TOK_R_TRUE || tk == TOK_R_FALSE) {
+        auto boolean = make<BooleanLiteral>(tk == TOK_R_TRUE ? "1" : "0");
+        next();
         return boolean;
-    } else if (lexer->tk == TOK_R_NULL) {
-        auto null = new NullLiteral();
-        lexer->match(lexer->tk);
+    } else if (tk == TOK_R_NULL) {
+        auto null = make<NullLiteral>();
+        next();
         return null;
-    } else if (lexer->tk == '[') {
-        lexer->match('[');
+    } else if (tk == '[') {
+        match('[');
         std::vector<Node*> elements;
-        if (lexer->tk != ']') {
+        if (tk != ']') {
             elements.push_back(parseExpression());
-            while (lexer->tk == ',') {
-                lexer->match(',');
+            while (tk == ',') {
+                match(',');
                 elements.push_back(parseExpression());
             }
         }
-        lexer->match(']');
-        return new ArrayLiteral(elements);
-    } else if (lexer->tk == '<') {
-        lexer->match('<');
+        match(']');
+        return make<ArrayLiteral>(elements);
+    } else if (tk == '<' && isGenericCall()) {
+        match('<');
         auto type = parseTypeIdent();
-        lexer->match('>');
+        match('>');
         auto name = parseVarIdent();
-        lexer->match('(');
+        match('(');
         std::vector<Node*> params;
-        if (lexer->tk != ')') {
+        if (tk != ')') {
             params.push_back(parseExpression());
-            while (lexer->tk == ',') {
-                lexer->match(',');
+            while (tk == ',') {
+                match(',');
                 params.push_back(parseExpression());
             }
         }
-        lexer->match(')');
-        return new FunctionCall(name, type, params);
-    } else if (lexer->tk == TOK_ID) {
+        match(')');
+        return make<FunctionCall>(name, type, params);
+    } else if (tk == TOK_ID) {
         auto name = parseVarIdent();
-        if (lexer->tk != '(')
+        if (tk != '(')
             return name;
         else {
-            lexer->match('(');
+            match('(');
             std::vector<Node*> params;
-            if (lexer->tk != ')') {
+            if (tk != ')') {
                 params.push_back(parseExpression());
-                while (lexer->tk == ',') {
-                    lexer->match(',');
+                while (tk == ',') {
+                    match(',');
                     params.push_back(parseExpression());
                 }
             }
-            lexer->match(')');
-            return new FunctionCall(name, NULL, params);
+            match(')');
+            return make<FunctionCall>(name, nullptr, params);
         }
     }
     return nullptr;
 }
 
-Node* Parser::parseBinaryOperator(const int token,
-                                  Node* (Parser::*callback)(void)) {
-    Node* node = (*this.*callback)();
-    while (lexer->tk == token) {
-        const int op = lexer->tk;
-        lexer->match(lexer->tk);
-        Node* right = (*this.*callback)();
-        node = new BinaryOperator(node, right, op);
-    }
-    return node;
-}
-
-Node* Parser::parseBinaryOperator(std::vector<int> tokens,
-                                  Node* (Parser::*callback)(void)) {
-    Node* node = (*this.*callback)();
-    while (std::count(tokens.begin(), tokens.end(), lexer->tk) > 0) {
-        const int op = lexer->tk;
-        lexer->match(lexer->tk);
-        Node* right = (*this.*callback)();
-        node = new BinaryOperator(node, right, op);
-    }
-    return node;
+// longest `<Type> name(` prefix isGenericCall() looks through
+static const int maxGenericLookahead = 64;
+
+// `<Type> name(` with any nesting in Type, told apart from a stray `<` by
+// reading ahead and rewinding, so nothing is consumed. The scan stops at
+// the first token that cannot be part of a type list and after
+// maxGenericLookahead tokens, so a run of stray `<`, each scanned as an
+// operand, stays linear.
+bool Parser::isGenericCall(void) {
+    const size_t start = mark();
+    auto scan = [&]() {
+        int depth = 1, scanned = 0;
+        next();
+        while (depth > 0) {
+            if (++scanned > maxGenericLookahead) return false;
+            if (tk == '<')
+                depth++;
+            else if (tk == '>')
+                depth--;
+            else if (tk == TOK_RSHIFT)
+                depth -= 2;
+            else if (tk != TOK_ID && tk != TOK_R_CONST && tk != ',' &&
+                     tk != '[' && tk != ']')
+                return false;
+            next();
+        }
+        if (depth < 0 || tk != TOK_ID) return false;
+        next();
+        while (tk == '.' && peek(1) == TOK_ID) {
+            if ((scanned += 2) > maxGenericLookahead) return false;
+            next();
+            next();
+        }
+        return tk == '(';
+    };
+    const bool generic = scan();
+    rewind(start);
+    return generic;
 }
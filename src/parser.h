@@ -9,15 +9,95 @@
 #include "ast.h"
 #include "common.h"
 #include "lexer.h"
+#include "tokenbuffer.h"
 
-class Parser {
+// Syntax errors of a parse in source order. Only the first `limit` are
+// kept, the rest are just counted, so a file of garbage cannot make the
+// report larger than the file.
+class Diagnostics {
   public:
-    Parser(Lexer* lexer) : lexer(lexer) {
+    std::vector<std::string> messages;
+    size_t dropped;
+    size_t limit;
+
+    Diagnostics(size_t limit = 100) : dropped(0), limit(limit) {}
+
+    void add(const std::string& message) {
+        if (messages.size() < limit)
+            messages.push_back(message);
+        else
+            dropped++;
+    }
+    size_t count(void) const {
+        return messages.size() + dropped;
     }
+    void clear(void) {
+        messages.clear();
+        dropped = 0;
+    }
+};
+
+// Owns everything a parse allocates. The tree returned by Parser::parse()
+// lives until the context is reset or destroyed, which frees all of it at
+// once.
+class ParseContext {
+  public:
+    Arena arena;
+    Diagnostics diagnostics;
+
+    void reset(void) {
+        arena.release();
+        diagnostics.clear();
+    }
+};
+
+class Parser {
+  public:
+    // Streaming: tokens are pulled from the lexer as the parser needs them.
+    Parser(Lexer* lexer, ParseContext* context);
+    // Pre-tokenized: the parser only indexes into the buffer.
+    Parser(TokenBuffer* tokens, ParseContext* context);
+    ~Parser();
+
+    // Syntax errors do not stop the parse. Each one is added to the
+    // context's diagnostics and replaced by a SyntaxError node, and parsing
+    // resumes after the next `;`, before the next `}` or at the next
+    // declaration, whichever comes first.
     Node* parse(void);
 
+    // tokens looked at, once per peek; more than the token count when the
+    // parser scans ahead to decide between alternatives
+    size_t peeks;
+
   private:
-    Lexer* lexer;
+    ParseContext* context;
+    TokenBuffer* tokens;
+    bool tokensOwned;
+    size_t cursor;
+    int tk;
+    size_t lastError;
+    // positions of the live marks, oldest first
+    std::vector<size_t> marks;
+
+    template<typename T, typename... Args> T* make(Args&&... args) {
+        return T::create(context->arena, std::forward<Args>(args)...);
+    }
+
+    int peek(int k);
+    std::string_view tkStr(void);
+    Symbol tkSymbol(void);
+    void next(void);
+    void match(int expectedTk);
+
+    [[noreturn]] void error(const std::string& message);
+    Node* recover(size_t start, const std::string& message);
+
+    // Speculative parsing: mark() remembers the cursor, rewind() goes back
+    // to it and unmark() keeps the tokens read since. Marks nest, and a
+    // streaming parser keeps every token from the oldest live mark on.
+    size_t mark(void);
+    void rewind(size_t position);
+    void unmark(void);
 
     Node* parseFile(void);
     Node* parseGlobalScope(void);
@@ -52,33 +132,14 @@ class Parser {
 
     Node* parseVarDecl(void);
 
-    Node* parseExpression(void);
-
-    Node* parseTernaryExpression(void);
-
-    Node* parseAssignExpression(void);
-
-    Node* parseLogicalOr(void);
-    Node* parseLogicalAnd(void);
-
-    Node* parseBitwiseOr(void);
-    Node* parseBitwiseXor(void);
-    Node* parseBitwiseAnd(void);
-
-    Node* parseEquality(void);
-    Node* parseRelational(void);
-    Node* parseShift(void);
-
-    Node* parseAdditive(void);
-    Node* parseMultiplicative(void);
+    // Binary and ternary operators by precedence climbing, stopping at the
+    // first operator that binds looser than minPower.
+    Node* parseExpression(int minPower = 0);
 
     Node* parseUnaryExpression(void);
 
     Node* parseElement(void);
-
-    // What in the C++ fuck?
-    Node* parseBinaryOperator(const int, Node* (Parser::*)(void));
-    Node* parseBinaryOperator(std::vector<int>, Node* (Parser::*)(void));
+    bool isGenericCall(void);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+static inline bool isSpaceByte(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+static inline bool isIdentByte(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+           (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+static int scalarWhitespace(const char* data, int pos, int end) {
+    while (pos < end && isSpaceByte(data[pos])) pos++;
+    return pos;
+}
+
+static int scalarIdentifier(const char* data, int pos, int end) {
+    while (pos < end && isIdentByte(data[pos])) pos++;
+    return pos;
+}
+
+static int scalarUntil(const char* data, int pos, int end, char a, char b,
+                       char c) {
+    while (pos < end && data[pos] != a && data[pos] != b && data[pos] != c)
+        pos++;
+    return pos;
+}
+
+#ifdef SCAN_X86
+
+// The vector bodies are written once as macros over the register width so
+// that the SSE2 and AVX2 kernels cannot drift apart. Bytes >= 0x80 are
+// negative as signed chars, so the signed range compares reject them.
+
+#define SCAN_KERNELS(NAME, ATTR, VEC, WIDTH, LOAD, SET1, CMPEQ, CMPGT, OR,     \
+                     AND, MOVEMASK, FULL)                                      \
+    ATTR static int NAME##Whitespace(const char* data, int pos, int end) {     \
+        const VEC space = SET1(' '), tab = SET1('\t'), lf = SET1('\n'),        \
+                  cr = SET1('\r');                                             \
+        for (; pos + WIDTH <= end; pos += WIDTH) {                             \
+            const VEC v = LOAD((const VEC*)(data + pos));                      \
+            const VEC hit = OR(OR(CMPEQ(v, space), CMPEQ(v, tab)),             \
+                               OR(CMPEQ(v, lf), CMPEQ(v, cr)));                \
+            const unsigned mask = ~(unsigned)MOVEMASK(hit) & FULL;             \
+            if (mask) return pos + __builtin_ctz(mask);                        \
+        }                                                                      \
+        return scalarWhitespace(data, pos, end);                               \
+    }                                                                          \
+                                                                               \
+    ATTR static int NAME##Identifier(const char* data, int pos, int end) {     \
+        const VEC lower = SET1(0x20), a = SET1('a' - 1), z = SET1('z' + 1),    \
+                  d0 = SET1('0' - 1), d9 = SET1('9' + 1),                      \
+                  underscore = SET1('_');                                      \
+        for (; pos + WIDTH <= end; pos += WIDTH) {                             \
+            const VEC v = LOAD((const VEC*)(data + pos));                      \
+            const VEC folded = OR(v, lower);                                   \
+            const VEC alpha = AND(CMPGT(folded, a), CMPGT(z, folded));         \
+            const VEC digit = AND(CMPGT(v, d0), CMPGT(d9, v));                 \
+            const VEC hit = OR(OR(alpha, digit), CMPEQ(v, underscore));        \
+            const unsigned mask = ~(unsigned)MOVEMASK(hit) & FULL;             \
+            if (mask) return pos + __builtin_ctz(mask);                        \
+        }                                                                      \
+        return scalarIdentifier(data, pos, end);                               \
+    }                                                                          \
+                                                                               \
+    ATTR static int NAME##Until(const char* data, int pos, int end, char a,    \
+                                char b, char c) {                              \
+        const VEC va = SET1(a), vb = SET1(b), vc = SET1(c);                    \
+        for (; pos + WIDTH <= end; pos += WIDTH) {                             \
+            const VEC v = LOAD((const VEC*)(data + pos));                      \
+            const VEC hit =                                                    \
+                    OR(OR(CMPEQ(v, va), CMPEQ(v, vb)), CMPEQ(v, vc));          \
+            const unsigned mask = (unsigned)MOVEMASK(hit);                     \
+            if (mask) return pos + __builtin_ctz(mask);                        \
+        }                                                                      \
+        return scalarUntil(data, pos, end, a, b, c);                           \
+    }
+
+SCAN_KERNELS(sse2, __attribute__((target("sse2"))), __m128i, 16,
+             _mm_loadu_si128, _mm_set1_epi8, _mm_cmpeq_epi8, _mm_cmpgt_epi8,
+             _mm_or_si128, _mm_and_si128, _mm_movemask_epi8, 0xFFFFu)
+
+SCAN_KERNELS(avx2, __attribute__((target("avx2"))), __m256i, 32,
+             _mm256_loadu_si256, _mm256_set1_epi8, _mm256_cmpeq_epi8,
+             _mm256_cmpgt_epi8, _mm256_or_si256, _mm256_and_si256,
+             _mm256_movemask_epi8, 0xFFFFFFFFu)
+
+#undef SCAN_KERNELS
+
+#endif
+
+int (*scanWhitespace)(const char*, int, int) = scalarWhitespace;
+int (*scanIdentifier)(const char*, int, int) = scalarIdentifier;
+int (*scanUntil)(const char*, int, int, char, char, char) = scalarUntil;
+
+static int currentLevel = SCAN_SCALAR;
+
+int scanSupported(void) {
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SCAN_AVX2;
+    if (__builtin_cpu_supports("sse2")) return SCAN_SSE2;
+#endif
+    return SCAN_SCALAR;
+}
+
+int scanLevel(void) {
+    return currentLevel;
+}
+
+void scanUse(int level) {
+    level = std::min(level, scanSupported());
+    switch (level) {
+#ifdef SCAN_X86
+    case SCAN_AVX2:
+        scanWhitespace = avx2Whitespace;
+        scanIdentifier = avx2Identifier;
+        scanUntil = avx2Until;
+        break;
+    case SCAN_SSE2:
+        scanWhitespace = sse2Whitespace;
+        scanIdentifier = sse2Identifier;
+        scanUntil = sse2Until;
+        break;
+#endif
+    default:
+        level = SCAN_SCALAR;
+        scanWhitespace = scalarWhitespace;
+        scanIdentifier = scalarIdentifier;
+        scanUntil = scalarUntil;
+    }
+    currentLevel = level;
+}
+
+const char* scanLevelName(int level) {
+    switch (level) {
+    case SCAN_AVX2: return "avx2";
+    case SCAN_SSE2: return "sse2";
+    }
+    return "scalar";
+}
+
+static struct ScanInit {
+    ScanInit() {
+        scanUse(scanSupported());
+    }
+} scanInit;
@@ -0,0 +1,36 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_SCAN
+#define CAPSTONE_SCAN
+
+#include "common.h"
+
+// Byte-run kernels for the lexer's inner loops. Each one takes the index
+// of the first byte to look at and returns the index of the first byte in
+// [pos, end) that ends the run, or end. The SSE2 and AVX2 versions look at
+// 16 or 32 bytes per step and are picked at startup from what the CPU
+// supports.
+
+enum SCAN_LEVELS {
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2,
+};
+
+// first byte that is not ' ', '\t', '\n' or '\r'
+extern int (*scanWhitespace)(const char* data, int pos, int end);
+// first byte that is not [A-Za-z0-9_]
+extern int (*scanIdentifier)(const char* data, int pos, int end);
+// first byte equal to a, b or c
+extern int (*scanUntil)(const char* data, int pos, int end, char a, char b,
+                        char c);
+
+int scanSupported(void);
+int scanLevel(void);
+void scanUse(int level);
+const char* scanLevelName(int level);
+
+#endif
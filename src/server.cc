@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "server.h"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "exception.h"
+
+// Messages claiming more than this are refused before anything is
+// allocated for them.
+static const uint32_t maxStrings = 1 << 16;
+static const uint64_t maxMessageBytes = 1 << 30;
+// A client that sends or takes nothing for this long is dropped, so it
+// cannot hold up the clients queued behind it.
+static const int clientTimeoutSeconds = 10;
+
+static bool sendAll(int fd, const void* data, size_t size) {
+    const char* bytes = (const char*)data;
+    while (size > 0) {
+        const ssize_t put = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        bytes += put;
+        size -= put;
+    }
+    return true;
+}
+
+static bool receiveAll(int fd, void* data, size_t size) {
+    char* bytes = (char*)data;
+    while (size > 0) {
+        const ssize_t got = recv(fd, bytes, size, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        bytes += got;
+        size -= got;
+    }
+    return true;
+}
+
+static bool sendStrings(int fd, const std::vector<std::string>& strings) {
+    std::string message;
+    auto put = [&](uint32_t n) { message.append((const char*)&n, sizeof(n)); };
+    put(strings.size());
+    for (const std::string& text : strings) {
+        put(text.size());
+        message += text;
+    }
+    return sendAll(fd, message.data(), message.size());
+}
+
+enum Received { RECEIVED, FAILED, TOO_LARGE };
+
+static Received receiveStrings(int fd, std::vector<std::string>& strings) {
+    uint32_t count;
+    if (!receiveAll(fd, &count, sizeof(count))) return FAILED;
+    if (count > maxStrings) return TOO_LARGE;
+    strings.resize(count);
+    uint64_t total = 0;
+    for (std::string& text : strings) {
+        uint32_t size;
+        if (!receiveAll(fd, &size, sizeof(size))) return FAILED;
+        if ((total += size) > maxMessageBytes) return TOO_LARGE;
+        text.resize(size);
+        if (size && !receiveAll(fd, &text[0], size)) return FAILED;
+    }
+    return RECEIVED;
+}
+
+static bool socketAddress(const std::string& path, sockaddr_un& address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) return false;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+CompileServer::CompileServer(const std::string& path, Handler handler)
+    : path(path), handler(handler), fd(-1) {
+    sockaddr_un address;
+    if (!socketAddress(path, address))
+        throw new Exception("Socket path too long: " + path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) throw new Exception("Could not create socket: " +
+                                    std::string(strerror(errno)));
+    unlink(path.c_str());
+    // the socket is created with mode 0600, other users cannot connect
+    const mode_t mask = umask(077);
+    const bool bound = bind(fd, (sockaddr*)&address, sizeof(address)) == 0;
+    umask(mask);
+    if (!bound || listen(fd, 64) < 0) {
+        const std::string error = strerror(errno);
+        close(fd);
+        throw new Exception("Could not listen on " + path + ": " + error);
+    }
+}
+
+CompileServer::~CompileServer() {
+    if (fd >= 0) close(fd);
+    unlink(path.c_str());
+}
+
+// the socket of the running server, removed when it is stopped
+static std::string serving;
+
+static void stop(int) {
+    unlink(serving.c_str());
+    _exit(0);
+}
+
+void CompileServer::run(void) {
+    // a client that goes away mid-reply must not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+    serving = path;
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    while (true) {
+        const int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            throw new Exception("Could not accept on " + path + ": " +
+                                strerror(errno));
+        }
+        timeval timeout = {clientTimeoutSeconds, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serve(client);
+        close(client);
+    }
+}
+
+// Requests run with the server's rights, so only its own user may send
+// them, whatever the mode of the socket file.
+static bool sameUser(int client) {
+    ucred peer;
+    socklen_t size = sizeof(peer);
+    return getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &size) == 0 &&
+           peer.uid == getuid();
+}
+
+void CompileServer::serve(int client) {
+    if (!sameUser(client)) return;
+    std::vector<std::string> strings;
+    const Received received = receiveStrings(client, strings);
+    if (received == TOO_LARGE) {
+        sendStrings(client, {"1", "", "ERROR: Request too large\n"});
+        return;
+    }
+    if (received != RECEIVED || strings.size() < 2) return;
+
+    ServerRequest request;
+    request.cwd = strings[0];
+    request.input = strings[1];
+    request.args.assign(strings.begin() + 2, strings.end());
+
+    std::ostringstream out, err;
+    int status;
+    try {
+        status = handler(request, out, err);
+    } catch (Exception* e) {
+        err << "ERROR: " << e->text << "\n";
+        delete e;
+        status = 1;
+    }
+    sendStrings(client, {std::to_string(status), out.str(), err.str()});
+}
+
+// A request the server did not receive whole is dropped unread, so until
+// it is sent nothing can have run.
+Forwarded forwardToServer(const std::string& path,
+                          const ServerRequest& request, ServerReply& reply) {
+    sockaddr_un address;
+    if (!socketAddress(path, address)) return NO_SERVER;
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return NO_SERVER;
+    if (connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        close(fd);
+        return NO_SERVER;
+    }
+
+    std::vector<std::string> strings = {request.cwd, request.input};
+    strings.insert(strings.end(), request.args.begin(), request.args.end());
+    if (!sendStrings(fd, strings)) {
+        close(fd);
+        return NO_SERVER;
+    }
+    std::vector<std::string> answer;
+    const bool ok =
+            receiveStrings(fd, answer) == RECEIVED && answer.size() == 3;
+    close(fd);
+    if (!ok) return REPLY_LOST;
+    reply.status = atoi(answer[0].c_str());
+    reply.out = answer[1];
+    reply.err = answer[2];
+    return REPLIED;
+}
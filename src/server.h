@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_SERVER
+#define CAPSTONE_SERVER
+
+#include "common.h"
+
+#include <functional>
+
+// A command line forwarded by a client: where it was run, what it would
+// have read from stdin and its arguments.
+struct ServerRequest {
+    std::string cwd;
+    std::string input;
+    std::vector<std::string> args;
+};
+
+// What the command printed and its exit status.
+struct ServerReply {
+    int status = 0;
+    std::string out;
+    std::string err;
+};
+
+// Runs forwarded command lines in one long-lived process, so whatever the
+// handler keeps between requests stays warm. Listens on a Unix domain
+// socket that only its own user can reach and takes one connection at a
+// time, dropping a client that stalls. Every message is a count and that many strings, each a length
+// and its bytes: a request is the cwd, the input and the arguments, a
+// reply the status, stdout and stderr. A request with too many strings or
+// bytes is answered with an error and not run.
+class CompileServer {
+  public:
+    typedef std::function<int(const ServerRequest& request, std::ostream& out,
+                              std::ostream& err)>
+            Handler;
+
+    // replaces a stale socket file at path
+    CompileServer(const std::string& path, Handler handler);
+    ~CompileServer();
+
+    // serves until the process is stopped
+    void run(void);
+
+  private:
+    std::string path;
+    Handler handler;
+    int fd;
+
+    void serve(int client);
+};
+
+enum Forwarded {
+    // the server ran the request, its reply is filled in
+    REPLIED,
+    // no server took the request, nothing was run
+    NO_SERVER,
+    // the server took the request but its reply was lost, so it may
+    // have run
+    REPLY_LOST,
+};
+
+// Sends a request to the server at path and waits for its reply.
+Forwarded forwardToServer(const std::string& path,
+                          const ServerRequest& request, ServerReply& reply);
+
+#endif
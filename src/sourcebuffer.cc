@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "sourcebuffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+SourceBuffer::SourceBuffer()
+    : data(nullptr), size(0), mapped(false), lines(nullptr) {
+}
+
+SourceBuffer::SourceBuffer(const std::string& text) : SourceBuffer() {
+    size = text.size();
+    char* copy = (char*)malloc(size + 1);
+    memcpy(copy, text.data(), size);
+    copy[size] = 0;
+    data = copy;
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped)
+        munmap((void*)data, size);
+    else
+        free((void*)data);
+    delete lines;
+}
+
+SourceBuffer* SourceBuffer::load(const std::string& path) {
+    const bool isStdin = path == "-";
+    const int fd = isStdin ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw new Exception("Could not open " + path + ": " + strerror(errno));
+
+    // an fd this opened is closed on every way out, the buffer unless
+    // it is returned
+    struct FdGuard {
+        int fd;
+        ~FdGuard() {
+            if (fd != STDIN_FILENO) close(fd);
+        }
+    } guard{fd};
+
+    std::unique_ptr<SourceBuffer> source(new SourceBuffer());
+    struct stat st;
+    const bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular && (uint64_t)st.st_size > maxSize) tooLarge(path);
+    if (regular && st.st_size > 0) {
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            source->data = (const char*)map;
+            source->size = st.st_size;
+            source->mapped = true;
+        }
+    }
+    if (!source->mapped) source->readAll(fd, path);
+    return source.release();
+}
+
+void SourceBuffer::tooLarge(const std::string& path) {
+    throw new Exception("Could not load " + path + ": larger than " +
+                        std::to_string(maxSize) + " bytes");
+}
+
+void SourceBuffer::readAll(int fd, const std::string& path) {
+    size_t capacity = 1 << 16;
+    size_t length = 0;
+    char* buffer = (char*)malloc(capacity);
+    for (;;) {
+        if (length == capacity)
+            buffer = (char*)realloc(buffer, capacity *= 2);
+        const ssize_t got = read(fd, buffer + length, capacity - length);
+        if (got == 0) break;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            free(buffer);
+            throw new Exception("Could not read " + path + ": " +
+                                strerror(errno));
+        }
+        length += got;
+        if (length > maxSize) {
+            free(buffer);
+            tooLarge(path);
+        }
+    }
+    data = buffer;
+    size = length;
+}
+
+SourceBuffer* SourceBuffer::edit(int offset, int removed,
+                                 std::string_view text) {
+    auto result = new SourceBuffer();
+    result->size = size - removed + text.size();
+    char* copy = (char*)malloc(result->size + 1);
+    memcpy(copy, data, offset);
+    memcpy(copy + offset, text.data(), text.size());
+    memcpy(copy + offset + text.size(), data + offset + removed,
+           size - offset - removed);
+    copy[result->size] = 0;
+    result->data = copy;
+    return result;
+}
+
+LineIndex& SourceBuffer::getLines() {
+    std::call_once(linesOnce, [this]() { lines = new LineIndex(data, size); });
+    return *lines;
+}
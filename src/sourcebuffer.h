@@ -0,0 +1,50 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_SOURCEBUFFER
+#define CAPSTONE_SOURCEBUFFER
+
+#include "common.h"
+
+#include <climits>
+
+#include "exception.h"
+#include "lineindex.h"
+
+// The bytes of one source file. Regular files are mapped read-only,
+// anything else (pipes, stdin) is read in one go. The data is never written
+// after loading, so any number of lexers on any threads can borrow one
+// buffer; it must outlive them. The data is not NUL terminated. Offsets
+// into it are ints, so loading a source of 2 GiB or more fails.
+class SourceBuffer {
+  public:
+    SourceBuffer(const std::string& text);
+    ~SourceBuffer();
+
+    // "-" reads stdin
+    static SourceBuffer* load(const std::string& path);
+
+    // a new buffer with `removed` bytes at `offset` replaced by `text`
+    SourceBuffer* edit(int offset, int removed, std::string_view text);
+
+    const char* data;
+    int size;
+
+    static const size_t maxSize = INT_MAX;
+
+    LineIndex& getLines();
+
+  private:
+    SourceBuffer();
+
+    bool mapped;
+    LineIndex* lines;
+    std::once_flag linesOnce;
+
+    void readAll(int fd, const std::string& path);
+    [[noreturn]] static void tooLarge(const std::string& path);
+};
+
+#endif
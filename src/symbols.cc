@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "symbols.h"
+
+uint64_t SymbolTable::hash(std::string_view name) {
+    const char* s = name.data();
+    size_t length = name.size();
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ length;
+    for (; length >= 8; s += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, s, 8);
+        h = (h ^ word) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, s, length);
+    h = (h ^ tail) * 0x94D049BB133111EBull;
+    return h ^ (h >> 29);
+}
+
+SymbolTable::SymbolTable() : next(0) {
+    for (auto& segment : segments) segment.store(nullptr);
+    intern(std::string_view());
+}
+
+SymbolTable::~SymbolTable() {
+    for (auto& segment : segments) delete[] segment.load();
+    for (Shard& shard : shards)
+        for (char* block : shard.blocks) free(block);
+}
+
+SymbolTable& SymbolTable::global(void) {
+    static SymbolTable table;
+    return table;
+}
+
+const char* SymbolTable::store(Shard& shard, std::string_view name) {
+    if (shard.blocks.empty() ||
+        shard.blockUsed + name.size() > shard.blockSize) {
+        shard.blockSize = std::max<size_t>(1 << 16, name.size());
+        shard.blocks.push_back((char*)malloc(shard.blockSize));
+        shard.blockUsed = 0;
+    }
+    char* copy = shard.blocks.back() + shard.blockUsed;
+    memcpy(copy, name.data(), name.size());
+    shard.blockUsed += name.size();
+    return copy;
+}
+
+void SymbolTable::publish(Symbol symbol, std::string_view name) {
+    std::atomic<std::string_view*>& segment = segments[symbol >> SEGMENT_BITS];
+    std::string_view* names = segment.load(std::memory_order_acquire);
+    if (!names) {
+        auto fresh = new std::string_view[1 << SEGMENT_BITS];
+        if (segment.compare_exchange_strong(names, fresh,
+                                            std::memory_order_acq_rel))
+            names = fresh;
+        else
+            delete[] fresh;
+    }
+    names[symbol & ((1 << SEGMENT_BITS) - 1)] = name;
+}
+
+void SymbolTable::grow(Shard& shard) {
+    std::vector<Slot> old(std::max<size_t>(64, shard.slots.size() * 2));
+    old.swap(shard.slots);
+    const size_t mask = shard.slots.size() - 1;
+    for (const Slot& slot : old) {
+        if (!slot.hash) continue;
+        size_t i = slot.hash & mask;
+        while (shard.slots[i].hash) i = (i + 1) & mask;
+        shard.slots[i] = slot;
+    }
+}
+
+Symbol SymbolTable::intern(std::string_view name) {
+    return intern(name, hash(name));
+}
+
+Symbol SymbolTable::intern(std::string_view name, uint64_t h) {
+    Shard& shard = shards[h % SHARDS];
+    // the low bits picked the shard, the slot hash uses the high ones and
+    // is never 0 so that 0 can mark an empty slot
+    const uint32_t hash = (uint32_t)(h >> 32) | 1;
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (shard.used * 2 >= shard.slots.size()) grow(shard);
+    const size_t mask = shard.slots.size() - 1;
+    size_t i = hash & mask;
+    for (; shard.slots[i].hash; i = (i + 1) & mask)
+        if (shard.slots[i].hash == hash &&
+            this->name(shard.slots[i].symbol) == name)
+            return shard.slots[i].symbol;
+
+    const Symbol symbol = next.fetch_add(1);
+    publish(symbol, std::string_view(store(shard, name), name.size()));
+    shard.slots[i] = {hash, symbol};
+    shard.used++;
+    return symbol;
+}
+
+std::string_view SymbolTable::name(Symbol symbol) {
+    return segments[symbol >> SEGMENT_BITS].load(std::memory_order_acquire)
+            [symbol & ((1 << SEGMENT_BITS) - 1)];
+}
+
+size_t SymbolTable::size(void) {
+    return next.load();
+}
@@ -0,0 +1,65 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_SYMBOLS
+#define CAPSTONE_SYMBOLS
+
+#include "common.h"
+
+#include <atomic>
+
+// Dense integer id of an interned identifier. Equal names always get the
+// same id, so comparing names is comparing ids. 0 is the empty name.
+typedef uint32_t Symbol;
+
+// Identifier interner shared by every lexer and parser thread. Names are
+// hashed to one of SHARDS independently locked tables, and their bytes are
+// copied once into an append-only arena so the views handed out stay
+// valid for the table's lifetime. Looking up the name of an id takes no
+// lock.
+class SymbolTable {
+  public:
+    SymbolTable();
+    ~SymbolTable();
+
+    Symbol intern(std::string_view name);
+    Symbol intern(std::string_view name, uint64_t hash);
+    std::string_view name(Symbol symbol);
+    size_t size(void);
+
+    static uint64_t hash(std::string_view name);
+
+    // the table the lexer interns into unless told otherwise
+    static SymbolTable& global(void);
+
+  private:
+    static const int SHARDS = 64;
+    static const int SEGMENT_BITS = 16;
+    static const int SEGMENTS = 1 << (32 - SEGMENT_BITS);
+
+    struct Slot {
+        uint32_t hash;
+        Symbol symbol;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::vector<Slot> slots;
+        size_t used = 0;
+        std::vector<char*> blocks;
+        size_t blockUsed = 0, blockSize = 0;
+    };
+
+    Shard shards[SHARDS];
+    std::atomic<uint32_t> next;
+    // id -> name, in fixed segments that never move once published
+    std::atomic<std::string_view*> segments[SEGMENTS];
+
+    const char* store(Shard& shard, std::string_view name);
+    void publish(Symbol symbol, std::string_view name);
+    void grow(Shard& shard);
+};
+
+#endif
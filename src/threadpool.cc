@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(int threads) : running(0), stopping(false) {
+    if (threads <= 0) threads = std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    for (int i = 0; i < threads; i++) workers.emplace_back([this]() { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        tasks.push_back(std::move(task));
+    }
+    ready.notify_one();
+}
+
+void ThreadPool::wait(void) {
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [this]() { return tasks.empty() && running == 0; });
+}
+
+int ThreadPool::size(void) {
+    return workers.size();
+}
+
+void ThreadPool::work(void) {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        ready.wait(guard, [this]() { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        running++;
+        guard.unlock();
+        task();
+        guard.lock();
+        if (--running == 0 && tasks.empty()) idle.notify_all();
+    }
+}
@@ -0,0 +1,41 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_THREADPOOL
+#define CAPSTONE_THREADPOOL
+
+#include "common.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+
+// Fixed set of worker threads taking tasks from one queue in the order they
+// were submitted. Tasks must not throw. The destructor waits for every
+// submitted task to finish.
+class ThreadPool {
+  public:
+    // 0 threads means one per hardware thread
+    ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    void wait(void);
+
+    int size(void);
+
+  private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex lock;
+    std::condition_variable ready, idle;
+    size_t running;
+    bool stopping;
+
+    void work(void);
+};
+
+#endif
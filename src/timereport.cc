@@ -0,0 +1,148 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "timereport.h"
+
+TimeReport::TimeReport(void)
+    : files(0), tokens(0), bytesRead(0), bytesWritten(0),
+      start(std::chrono::steady_clock::now()) {
+    for (auto& time : nanos) time = 0;
+    for (auto& count : nodes) count = 0;
+}
+
+void TimeReport::add(Phase phase, std::chrono::steady_clock::duration time) {
+    nanos[phase] +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+static void countKinds(Node* node, uint64_t* counts) {
+    counts[(int)node->kind]++;
+    forEachChild(node, [&](Node* child) { countKinds(child, counts); });
+}
+
+static void countKinds(const FlatView& view, NodeId id, uint64_t* counts) {
+    counts[(int)view.kind(id)]++;
+    forEachChild(view, id,
+                 [&](NodeId child) { countKinds(view, child, counts); });
+}
+
+// Counted locally first so threads only meet once per kind.
+void TimeReport::countNodes(Node* root) {
+    uint64_t counts[NODE_KINDS] = {};
+    if (root) countKinds(root, counts);
+    for (int i = 0; i < NODE_KINDS; i++)
+        if (counts[i]) nodes[i] += counts[i];
+}
+
+void TimeReport::countNodes(const FlatView& view) {
+    uint64_t counts[NODE_KINDS] = {};
+    if (view.root) countKinds(view, view.root, counts);
+    for (int i = 0; i < NODE_KINDS; i++)
+        if (counts[i]) nodes[i] += counts[i];
+}
+
+const char* TimeReport::phaseName(Phase phase) {
+    switch (phase) {
+    case LOAD: return "load";
+    case CACHE: return "cache";
+    case LEX: return "lex";
+    case PARSE: return "parse";
+    case JSON: return "json";
+    case FLATTEN: return "flatten";
+    case WRITE: return "write";
+    default: return "unknown";
+    }
+}
+
+double TimeReport::seconds(Phase phase) {
+    return nanos[phase] / 1e9;
+}
+
+double TimeReport::wallSeconds(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+            .count();
+}
+
+// Phase times are summed over threads, so with many files on many workers
+// their total can be more than the wall time.
+void TimeReport::print(std::ostream& out) {
+    double total = 0;
+    for (int i = 0; i < PHASES; i++) total += seconds((Phase)i);
+    char line[128];
+
+    out << "phase           seconds       %\n";
+    for (int i = 0; i < PHASES; i++) {
+        snprintf(line, sizeof(line), "%-12s %10.6f %7.1f\n",
+                 phaseName((Phase)i), seconds((Phase)i),
+                 total > 0 ? seconds((Phase)i) * 100 / total : 0.0);
+        out << line;
+    }
+    snprintf(line, sizeof(line), "%-12s %10.6f\n%-12s %10.6f\n", "total",
+             total, "wall", wallSeconds());
+    out << line << "\n";
+
+    uint64_t nodeTotal = 0;
+    for (auto& count : nodes) nodeTotal += count;
+    const std::pair<const char*, uint64_t> counters[] = {
+            {"files", files},           {"bytes read", bytesRead},
+            {"bytes written", bytesWritten}, {"tokens", tokens},
+            {"nodes", nodeTotal}};
+    for (auto& counter : counters) {
+        snprintf(line, sizeof(line), "%-24s %10llu\n", counter.first,
+                 (unsigned long long)counter.second);
+        out << line;
+    }
+    for (int i = 0; i < NODE_KINDS; i++) {
+        if (!nodes[i]) continue;
+        snprintf(line, sizeof(line), "  %-22s %10llu\n",
+                 getNodeKindStr((NodeKind)i).c_str(),
+                 (unsigned long long)nodes[i]);
+        out << line;
+    }
+}
+
+static void writeSeconds(JsonWriter& out, double seconds) {
+    char number[32];
+    snprintf(number, sizeof(number), "%.9f", seconds);
+    out.write(number);
+}
+
+static void writeCount(JsonWriter& out, const char* name, uint64_t count) {
+    out.write("\"");
+    out.write(name);
+    out.write("\": ");
+    out.write(std::to_string(count));
+}
+
+void TimeReport::writeJSON(JsonWriter& out) {
+    out.write("{\"phases\": {");
+    for (int i = 0; i < PHASES; i++) {
+        if (i) out.write(", ");
+        out.write("\"");
+        out.write(phaseName((Phase)i));
+        out.write("\": ");
+        writeSeconds(out, seconds((Phase)i));
+    }
+    out.write("}, \"wall\": ");
+    writeSeconds(out, wallSeconds());
+    out.write(", ");
+    writeCount(out, "files", files);
+    out.write(", ");
+    writeCount(out, "bytesRead", bytesRead);
+    out.write(", ");
+    writeCount(out, "bytesWritten", bytesWritten);
+    out.write(", ");
+    writeCount(out, "tokens", tokens);
+    out.write(", \"nodes\": {");
+    bool first = true;
+    for (int i = 0; i < NODE_KINDS; i++) {
+        if (!nodes[i]) continue;
+        if (!first) out.write(", ");
+        first = false;
+        writeCount(out, getNodeKindStr((NodeKind)i).c_str(), nodes[i]);
+    }
+    out.write("}}\n");
+}
@@ -0,0 +1,66 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_TIMEREPORT
+#define CAPSTONE_TIMEREPORT
+
+#include "common.h"
+
+#include <atomic>
+#include <chrono>
+
+#include "flatast.h"
+
+// Time spent in each phase of the driver and what went through it, summed
+// over every file and thread of a run. Phases are timed by PhaseTimer and
+// nodes are counted by walking finished trees, so nothing is added to the
+// lexer or parser. Without a report the driver passes nullptr and the only
+// cost is a null check per phase.
+class TimeReport {
+  public:
+    enum Phase { LOAD, CACHE, LEX, PARSE, JSON, FLATTEN, WRITE, PHASES };
+
+    TimeReport(void);
+
+    void add(Phase phase, std::chrono::steady_clock::duration time);
+    void countNodes(Node* root);
+    void countNodes(const FlatView& view);
+
+    // A table for people, or one JSON object with the same numbers.
+    void print(std::ostream& out);
+    void writeJSON(JsonWriter& out);
+
+    static const char* phaseName(Phase phase);
+
+    std::atomic<uint64_t> files, tokens, bytesRead, bytesWritten;
+
+  private:
+    std::chrono::steady_clock::time_point start;
+    std::atomic<int64_t> nanos[PHASES];
+    std::atomic<uint64_t> nodes[NODE_KINDS];
+
+    double seconds(Phase phase);
+    double wallSeconds(void);
+};
+
+// Adds the time until the end of its scope to a phase of the report, if
+// there is one.
+class PhaseTimer {
+  public:
+    PhaseTimer(TimeReport* report, TimeReport::Phase phase)
+        : report(report), phase(phase) {
+        if (report) start = std::chrono::steady_clock::now();
+    }
+    ~PhaseTimer() {
+        if (report) report->add(phase, std::chrono::steady_clock::now() - start);
+    }
+
+  private:
+    TimeReport* report;
+    TimeReport::Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
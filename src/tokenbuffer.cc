@@ -0,0 +1,269 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "tokenbuffer.h"
+
+#include <thread>
+
+TokenBuffer::TokenBuffer(Lexer* lexer) : lexer(lexer), first(0), done(false) {
+}
+
+void TokenBuffer::push(void) {
+    kinds.push_back(lexer->tk);
+    offsets.push_back(lexer->tokenStart);
+    lengths.push_back(lexer->tokenEnd - lexer->tokenStart + 1);
+    symbols.push_back(lexer->tkSymbol);
+    if (lexer->tk == TOK_EOF)
+        done = true;
+    else
+        lexer->getNextToken();
+}
+
+void TokenBuffer::tokenize(void) {
+    while (!done) push();
+}
+
+void TokenBuffer::append(TokenBuffer& other, bool withEof) {
+    const size_t count = other.kinds.size() - (withEof ? 0 : 1);
+    kinds.insert(kinds.end(), other.kinds.begin(),
+                 other.kinds.begin() + count);
+    offsets.insert(offsets.end(), other.offsets.begin(),
+                   other.offsets.begin() + count);
+    lengths.insert(lengths.end(), other.lengths.begin(),
+                   other.lengths.begin() + count);
+    symbols.insert(symbols.end(), other.symbols.begin(),
+                   other.symbols.begin() + count);
+}
+
+// Lex the whole input on up to `threads` threads. Chunks start at line
+// breaks that findSplitPoints saw outside strings and comments, and each
+// chunk is lexed by a sub-lexer over the shared data, so offsets are
+// already absolute and stitching is concatenation. A chunk whose lexer
+// ran past its end (a string or comment crossing the split) or stopped
+// short of it (a NUL) is relexed serially from its start instead, so the
+// result always matches tokenize().
+void TokenBuffer::tokenizeParallel(int threads) {
+    static const int minChunk = 1 << 20;
+    const int start = lexer->dataStart, end = lexer->dataEnd;
+    const int chunks = std::min(threads, (end - start) / minChunk);
+    if (chunks < 2 || size() != 0) return tokenize();
+
+    std::vector<int> splits = findSplitPoints(lexer->data, start, end, chunks);
+    const int count = splits.size() - 1;
+    std::vector<Lexer*> lexers(count);
+    std::vector<TokenBuffer*> parts(count);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < count; i++)
+        workers.emplace_back([&, i]() {
+            lexers[i] = new Lexer(lexer, splits[i], splits[i + 1]);
+            parts[i] = new TokenBuffer(lexers[i]);
+            parts[i]->tokenize();
+        });
+    for (std::thread& worker : workers) worker.join();
+
+    size_t total = 0;
+    for (TokenBuffer* part : parts) total += part->kinds.size();
+    kinds.reserve(total);
+    offsets.reserve(total);
+    lengths.reserve(total);
+    symbols.reserve(total);
+
+    int i = 0;
+    for (; i < count - 1; i++) {
+        if ((int)parts[i]->offsets.back() != splits[i + 1]) break;
+        append(*parts[i], false);
+    }
+    if (i == count - 1) {
+        append(*parts[i], true);
+    } else {
+        Lexer rest(lexer, splits[i], end);
+        TokenBuffer serial(&rest);
+        serial.tokenize();
+        append(serial, true);
+    }
+
+    for (int j = 0; j < count; j++) {
+        delete parts[j];
+        delete lexers[j];
+    }
+    done = true;
+}
+
+// Replace [from, to) of v with replacement, in place when the size stays.
+template<typename T>
+static void splice(std::vector<T>& v, size_t from, size_t to,
+                   const std::vector<T>& replacement) {
+    if (to - from == replacement.size()) {
+        std::copy(replacement.begin(), replacement.end(), v.begin() + from);
+    } else {
+        v.erase(v.begin() + from, v.begin() + to);
+        v.insert(v.begin() + from, replacement.begin(), replacement.end());
+    }
+}
+
+// Update a fully tokenized buffer for an edit. `lexer` reads the new
+// source, which is the old one with `removed` bytes at `offset` replaced by
+// `inserted` bytes. The lexer carries no state between tokens except its
+// position, so relexing starts where the last token wholly before the edit
+// ended and stops at the first new token past the edit that starts where an
+// old token started; everything after it is the old stream shifted by the
+// size change. Returns the number of tokens lexed.
+int TokenBuffer::relex(Lexer* lexer, int offset, int removed, int inserted) {
+    ASSERT(done && first == 0);
+    this->lexer = lexer;
+    const int delta = inserted - removed;
+    const int editEnd = offset + inserted;
+
+    // tokens that end (including the byte that ended them) before the edit
+    // cannot change
+    size_t from = 0, to = kinds.size();
+    while (from < to) {
+        const size_t mid = (from + to) / 2;
+        if (offsets[mid] + lengths[mid] < (uint32_t)offset)
+            from = mid + 1;
+        else
+            to = mid;
+    }
+    const int restart = from ? offsets[from - 1] + lengths[from - 1] : 0;
+
+    Lexer sub(lexer, restart, lexer->dataEnd);
+    TokenBuffer fresh(&sub);
+    size_t reuse = from;
+    for (;;) {
+        if (sub.tokenStart >= editEnd) {
+            const uint32_t old = sub.tokenStart - delta;
+            while (reuse < kinds.size() && offsets[reuse] < old) reuse++;
+            if (reuse < kinds.size() && offsets[reuse] == old) break;
+        }
+        const bool eof = sub.tk == TOK_EOF;
+        fresh.push();
+        if (eof) {
+            reuse = kinds.size();
+            break;
+        }
+    }
+
+    if (delta)
+        for (size_t i = reuse; i < offsets.size(); i++) offsets[i] += delta;
+    splice(kinds, from, reuse, fresh.kinds);
+    splice(offsets, from, reuse, fresh.offsets);
+    splice(lengths, from, reuse, fresh.lengths);
+    splice(symbols, from, reuse, fresh.symbols);
+    return fresh.kinds.size();
+}
+
+// Split [start, end) into about `chunks` pieces, each ending just after a
+// newline in plain code. Only quotes, escapes and comment delimiters are
+// tracked, which is enough to know that no token spans the newline.
+std::vector<int> findSplitPoints(const char* data, int start, int end,
+                                 int chunks) {
+    std::vector<int> splits = {start};
+    const long step = ((long)end - start) / chunks;
+    long target = start + step;
+    int p = start;
+    while (p < end && splits.size() < (size_t)chunks) {
+        // [p, q) is code without quotes or slashes
+        const int q = scanUntil(data, p, end, '"', '\'', '/');
+        while (q > target && splits.size() < (size_t)chunks) {
+            const int from = std::max<long>(p, target);
+            const char* nl = (const char*)memchr(data + from, '\n', q - from);
+            if (!nl) break;
+            splits.push_back(nl - data + 1);
+            target = std::max(target + step, (long)splits.back());
+        }
+        p = q;
+        if (p >= end) break;
+
+        const char ch = data[p];
+        const char next = p + 1 < end ? data[p + 1] : 0;
+        if (ch == '/' && next == '/') {
+            p = scanUntil(data, p + 2, end, '\n', 0, 0) + 1;
+        } else if (ch == '/' && next == '*') {
+            const int body = p + 2;
+            p = body;
+            while ((p = scanUntil(data, p, end, '/', 0, 0)) < end &&
+                   data[p] && (p == body || data[p - 1] != '*'))
+                p++;
+            p++;
+        } else if (ch == '"' || ch == '\'') {
+            p++;
+            while ((p = scanUntil(data, p, end, ch, '\\', 0)) < end &&
+                   data[p] == '\\') {
+                const char escaped = p + 1 < end ? data[p + 1] : 0;
+                // '\x41' and '\101' swallow two more bytes, quotes included
+                if (ch == '\'' &&
+                    (escaped == 'x' || (escaped >= '0' && escaped <= '7')))
+                    p += 4;
+                else
+                    p += 2;
+            }
+            p++;
+        } else {
+            p++;
+        }
+    }
+    splits.push_back(end);
+    return splits;
+}
+
+bool TokenBuffer::fill(size_t index) {
+    while (!done && index >= size()) push();
+    return index < size();
+}
+
+void TokenBuffer::release(size_t index) {
+    const size_t count = std::min(index, size()) - first;
+    kinds.erase(kinds.begin(), kinds.begin() + count);
+    offsets.erase(offsets.begin(), offsets.begin() + count);
+    lengths.erase(lengths.begin(), lengths.begin() + count);
+    symbols.erase(symbols.begin(), symbols.begin() + count);
+    first += count;
+}
+
+size_t TokenBuffer::size(void) {
+    return first + kinds.size();
+}
+
+int TokenBuffer::kind(size_t index) {
+    if (!fill(index)) return TOK_EOF;
+    return kinds[index - first];
+}
+
+std::string_view TokenBuffer::text(size_t index) {
+    if (!fill(index)) return std::string_view();
+    const size_t i = index - first;
+    const char* start = lexer->data + offsets[i];
+    switch (kinds[i]) {
+    case TOK_ID:
+    case TOK_INT:
+    case TOK_FLOAT: return std::string_view(start, lengths[i]);
+    case TOK_STR: {
+        // The span covers both quotes (or runs one past the end of an
+        // unterminated literal), the body is everything in between.
+        std::string_view body(start + 1, lengths[i] - 2);
+        if (body.find('\\') == std::string_view::npos) return body;
+        lexer->decodeString(offsets[i] + 1, *start, escapeBuf);
+        return escapeBuf;
+    }
+    }
+    return std::string_view();
+}
+
+Symbol TokenBuffer::symbol(size_t index) {
+    return fill(index) ? symbols[index - first] : 0;
+}
+
+// Past the last token this is the end of the input the lexer reached.
+std::string TokenBuffer::getPosition(size_t index) {
+    if (!fill(index)) return lexer->getPosition();
+    return lexer->getPosition(offsets[index - first]);
+}
+
+size_t TokenBuffer::bytesReserved(void) {
+    return kinds.capacity() * sizeof(uint16_t) +
+           offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) +
+           symbols.capacity() * sizeof(Symbol) + escapeBuf.capacity();
+}
@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_TOKENBUFFER
+#define CAPSTONE_TOKENBUFFER
+
+#include "common.h"
+
+#include "lexer.h"
+
+// Flat token storage for the parser, kept as parallel arrays. Tokens are
+// either lexed up front with tokenize() or tokenizeParallel(), or pulled
+// from the lexer on demand with fill(). Indices are absolute; tokens
+// before `first` have been released by a streaming reader.
+class TokenBuffer {
+  public:
+    TokenBuffer(Lexer* lexer);
+
+    Lexer* lexer;
+
+    std::vector<uint16_t> kinds;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<Symbol> symbols;
+    size_t first;
+
+    void tokenize(void);
+    void tokenizeParallel(int threads);
+    int relex(Lexer* lexer, int offset, int removed, int inserted);
+    bool fill(size_t index);
+    void release(size_t index);
+
+    size_t size(void);
+    int kind(size_t index);
+    std::string_view text(size_t index);
+    Symbol symbol(size_t index);
+    std::string getPosition(size_t index);
+
+    // heap bytes held by the token arrays
+    size_t bytesReserved(void);
+
+  private:
+    std::string escapeBuf;
+    bool done;
+
+    void push(void);
+    void append(TokenBuffer& other, bool withEof);
+};
+
+std::vector<int> findSplitPoints(const char* data, int start, int end,
+                                 int chunks);
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "trace.h"
+
+#include "utils.h"
+
+unsigned Trace::categories = 0;
+int Trace::level = CAPSTONE_TRACE_LEVEL;
+std::ostream* Trace::sink = &std::cerr;
+
+static const unsigned categoryList[] = {Trace::SOURCE, Trace::JSON,
+                                        Trace::TOKENS, Trace::PARSER};
+
+const char* Trace::name(unsigned category) {
+    switch (category) {
+    case SOURCE: return "source";
+    case JSON: return "json";
+    case TOKENS: return "tokens";
+    case PARSER: return "parser";
+    default: return "trace";
+    }
+}
+
+int Trace::levelOf(unsigned category) {
+    return category == TOKENS || category == PARSER ? DEBUG : INFO;
+}
+
+std::string Trace::compiledOut(unsigned categories) {
+    std::string names;
+    for (unsigned category : categoryList) {
+        if (!(categories & category) ||
+            levelOf(category) <= CAPSTONE_TRACE_LEVEL)
+            continue;
+        if (!names.empty()) names += ",";
+        names += name(category);
+    }
+    return names;
+}
+
+bool Trace::enable(const std::string& names, unsigned* named) {
+    for (const std::string& part : splitStringIntoVector(names, ',')) {
+        const std::string wanted = stripWhitespace(part);
+        if (wanted.empty()) continue;
+        if (wanted == "all") {
+            categories = ALL;
+            continue;
+        }
+        bool found = false;
+        for (unsigned category : categoryList) {
+            if (wanted == name(category)) {
+                categories |= category;
+                if (named) *named |= category;
+                found = true;
+            }
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+void Trace::write(unsigned category, const std::string& message) {
+    static std::mutex lock;
+    std::unique_lock<std::mutex> guard(lock);
+    *sink << "[" << name(category) << "] " << message << "\n";
+}
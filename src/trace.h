@@ -0,0 +1,72 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_TRACE
+#define CAPSTONE_TRACE
+
+#include "common.h"
+
+// Most detailed trace level compiled in. Trace points above it are
+// constant-false conditions the compiler removes, arguments and all.
+#ifndef CAPSTONE_TRACE_LEVEL
+#define CAPSTONE_TRACE_LEVEL 1
+#endif
+
+// Trace output by category and level. Categories are off until enabled,
+// usually from the driver's --trace flag, and a trace point whose category
+// or level is off costs one test and never formats its message.
+class Trace {
+  public:
+    enum Level { INFO = 1, DEBUG = 2 };
+
+    enum Category : unsigned {
+        SOURCE = 1 << 0,  // each input as it was read
+        JSON = 1 << 1,    // each tree as JSON
+        TOKENS = 1 << 2,  // each token of an input
+        PARSER = 1 << 3,  // grammar rules as they are entered
+        ALL = ~0u
+    };
+
+    static unsigned categories;
+    static int level;
+    // where write() goes, std::cerr unless changed
+    static std::ostream* sink;
+
+    static bool enabled(int level, unsigned category) {
+        return level <= Trace::level && (categories & category);
+    }
+
+    // Turns on a comma separated list of category names, or "all". False
+    // if a name is not known. `named`, if given, gets the categories that
+    // were named rather than turned on by "all".
+    static bool enable(const std::string& names, unsigned* named = nullptr);
+
+    static const char* name(unsigned category);
+    // the level of a category's trace points
+    static int levelOf(unsigned category);
+    // Comma separated names of the categories whose trace points are all
+    // above CAPSTONE_TRACE_LEVEL and so print nothing in this build.
+    static std::string compiledOut(unsigned categories);
+
+    // One line to the sink, prefixed by the category; lines from different
+    // threads do not interleave.
+    static void write(unsigned category, const std::string& message);
+};
+
+#define TRACE_ENABLED(level, category) \
+    ((level) <= CAPSTONE_TRACE_LEVEL && Trace::enabled(level, category))
+
+// TRACE(Trace::DEBUG, Trace::PARSER, "rule " << name) streams its message
+// only when the trace point is on.
+#define TRACE(level, category, message)                     \
+    do {                                                    \
+        if (TRACE_ENABLED(level, category)) {               \
+            std::ostringstream traceLine;                   \
+            traceLine << message;                           \
+            Trace::write(category, traceLine.str());        \
+        }                                                   \
+    } while (0)
+
+#endif
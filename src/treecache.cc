@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "treecache.h"
+
+TreeCache::TreeCache(uint64_t limit)
+    : hits(0), misses(0), limit(limit), used(0) {
+}
+
+std::shared_ptr<const FlatTree> TreeCache::load(uint64_t key) {
+    std::unique_lock<std::mutex> guard(lock);
+    auto found = index.find(key);
+    if (found == index.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    return found->second->tree;
+}
+
+void TreeCache::store(uint64_t key, std::shared_ptr<const FlatTree> tree) {
+    const size_t size = tree->bytes();
+    // a tree over the whole limit would only push everything else out
+    if (size > limit) return;
+
+    std::unique_lock<std::mutex> guard(lock);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        used -= found->second->bytes;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+    entries.push_front(Entry{key, std::move(tree), size});
+    index[key] = entries.begin();
+    used += size;
+
+    while (used > limit) {
+        used -= entries.back().bytes;
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+size_t TreeCache::bytes(void) {
+    std::unique_lock<std::mutex> guard(lock);
+    return used;
+}
+
+size_t TreeCache::size(void) {
+    std::unique_lock<std::mutex> guard(lock);
+    return entries.size();
+}
@@ -0,0 +1,51 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#ifndef CAPSTONE_TREECACHE
+#define CAPSTONE_TREECACHE
+
+#include "common.h"
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+#include "flatast.h"
+
+// Flat trees kept in memory by a compile server, under the same keys as
+// ParseCache entries. Once the trees take more than the limit the least
+// recently used are dropped; a tree that is still being read stays alive
+// until its reader lets go of it. Safe to share between threads.
+class TreeCache {
+  public:
+    static const uint64_t defaultLimit = 256 << 20;
+
+    TreeCache(uint64_t limit = defaultLimit);
+
+    // the cached tree, or nullptr on a miss
+    std::shared_ptr<const FlatTree> load(uint64_t key);
+    void store(uint64_t key, std::shared_ptr<const FlatTree> tree);
+
+    size_t bytes(void);
+    size_t size(void);
+
+    std::atomic<size_t> hits, misses;
+
+  private:
+    struct Entry {
+        uint64_t key;
+        std::shared_ptr<const FlatTree> tree;
+        size_t bytes;
+    };
+
+    std::mutex lock;
+    // most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    uint64_t limit;
+    size_t used;
+};
+
+#endif
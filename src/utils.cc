@@ -105,11 +105,10 @@ std::string stringFormat(const std::string& format, Args... args) {
 }
 
 std::string readFile(const std::string& path) {
-    std::ifstream inputFile(path);
-    if (!inputFile.is_open())
-        return ""; // std::printf("Could not open file\n");
-    return std::string(std::istreambuf_iterator<char>(inputFile),
-                       std::istreambuf_iterator<char>());
+    SourceBuffer* source = SourceBuffer::load(path);
+    std::string text(source->data, source->size);
+    delete source;
+    return text;
 }
 
 std::string ignoreShebang(const std::string& code) {
@@ -193,7 +192,7 @@ std::string stripWhitespace(const std::string& subject) {
     return result;
 }
 
-void dumpStringToFile(const std::string& filename, const std::string& content) {
+void dumpStringToFile(const std::string& filename, std::string_view content) {
     std::ofstream file;
     file.open(filename);
     file << content;
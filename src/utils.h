@@ -8,6 +8,8 @@
 
 #include "common.h"
 
+#include "sourcebuffer.h"
+
 bool isWhitespace(char ch);
 bool isNumeric(char ch);
 bool isNumber(const std::string& str);
@@ -56,6 +58,6 @@ std::string replaceAllStringInString(std::string subject,
 
 std::string stripWhitespace(const std::string& subject);
 
-void dumpStringToFile(const std::string& filename, const std::string& content);
+void dumpStringToFile(const std::string& filename, std::string_view content);
 
 #endif
\ No newline at end of file
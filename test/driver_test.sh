@@ -0,0 +1,29 @@
+#!/bin/sh
+#
+# Runs the driver binary given as $1 over a directory with two bad files
+# and a good one, and checks that the run fails and that every error line
+# names the file it came from.
+
+capstone=$1
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+mkdir -p "$dir/sub"
+printf 'func f() { x = (1; }\n' > "$dir/a.cap"
+printf 'class {\n' > "$dir/sub/b.cap"
+printf 'func g() {}\n' > "$dir/ok.cap"
+
+fail() {
+    echo "driver: $1"
+    echo "$output"
+    exit 1
+}
+
+output=$("$capstone" "$dir" 2>&1) && fail "bad files did not fail the run"
+echo "$output" | grep -q "^ERROR: $dir/a.cap: " || fail "no error for a.cap"
+echo "$output" | grep -q "^ERROR: $dir/sub/b.cap: " || fail "no error for b.cap"
+echo "$output" | grep "^ERROR: " | grep -qv "^ERROR: $dir/\(a\|sub/b\).cap: " &&
+    fail "an error line does not name a bad file"
+[ -f "$dir/ok.json" ] || fail "the good file was not compiled"
+
+echo "driver: errors name their files ok"
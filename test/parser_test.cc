@@ -0,0 +1,54 @@
+/**
+ * Copyright (C) 2021-2022 Justus Languell
+ * This file is part of Capstone, which is licensed under the MIT license.
+ * For more details, see ./license.txt or write <jus@gtsbr.org>.
+ */
+#include "parser.h"
+
+// A streaming parser pulls tokens as it goes and releases the ones behind
+// it. Generic calls are told apart from comparisons by scanning ahead from
+// a mark and rewinding, and with a call every few tokens some of those
+// scans pull in new tokens while the window is due to be released. The
+// tree must come out the same as from tokens lexed up front, and the
+// parser asserts that it never rewinds into released tokens.
+
+static std::string parseJSON(const std::string& source, bool streaming) {
+    Lexer lexer(source);
+    ParseContext context;
+    Node* root;
+    if (streaming) {
+        Parser parser(&lexer, &context);
+        root = parser.parse();
+    } else {
+        TokenBuffer tokens(&lexer);
+        tokens.tokenize();
+        Parser parser(&tokens, &context);
+        root = parser.parse();
+    }
+    std::string json = root ? root->toJSON() : "null";
+    for (const std::string& message : context.diagnostics.messages)
+        json += "\n" + message;
+    return json;
+}
+
+int main(void) {
+    std::string source = "func f() {\n";
+    for (int i = 0; i < 4000; i++)
+        source += "    x = <Map<a, b, c, d>[][]> make(" + std::to_string(i) +
+                  ");\n    y = a < b;\n";
+    source += "}\n";
+
+    const std::string streamed = parseJSON(source, true);
+    const std::string buffered = parseJSON(source, false);
+    if (streamed != buffered) {
+        std::printf("parser: streaming and buffered trees differ\n");
+        return 1;
+    }
+    if (streamed.find("\"_type\": \"SyntaxError\"") != std::string::npos) {
+        std::printf("parser: unexpected syntax error\n");
+        return 1;
+    }
+    std::printf("parser: rewind across refills ok, %zu bytes of JSON\n",
+                streamed.size());
+    return 0;
+}